@@ -0,0 +1,322 @@
+/*
+Microbenchmarks for the world API and the diffusion fields. Every benchmark runs over a set of board sizes or populations, is
+repeated a number of times after some warmup runs, and reports the fastest and the median run.
+
+    economia_bench [--repeat n] [--warmup n] [--max-size n] [--max-people n] [--filter name] [--json file]
+
+Board sizes go from 7x7 to 4096x4096, a 4096x4096 board needs about 256MB so --max-size can cut the
+list short. The bytes are what the memory tracker counted for the world or the field. The JSON output is meant to be kept as a baseline and compared against after a change.
+*/
+
+#include "raylib.h"
+#include "world.hpp"
+#include "field.hpp"
+#include "memory.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#define BENCH_RESULTS_MAX 64
+#define BENCH_REPEAT_MAX 100
+#define BENCH_LOOKUPS (1 << 20)        // Random accesses per run of the lookup benchmarks
+#define BENCH_UPDATE_TILES (1 << 22)   // world_update runs enough ticks to touch this many tiles
+
+static const int _board_sizes[] = { 7, 64, 256, 1024, 4096 };
+static const int _populations[] = { 100, 1000, 10000, 100000, 1000000 };
+
+struct BenchConfig {
+    int repeat;
+    int warmup;
+    int max_size;
+    int max_people;
+    const char* filter;
+    const char* json;
+};
+
+// One timed run
+struct BenchSample {
+    double ns;
+    long long ops;
+    long long tiles;        // Tiles touched by all ops together
+    size_t bytes;           // Bytes the measured thing allocated, 0 for a world of the board size
+};
+
+// What a benchmark returns when it can't run, bench_run skips it
+#define BENCH_FAILED BenchSample{ 0 }
+
+struct BenchResult {
+    const char* name;
+    int size;
+    int people;
+    long long ops;          // Per run
+    long long tiles;        // Tiles touched per run
+    double ns_min;
+    double ns_median;
+    size_t bytes;
+};
+
+static BenchResult _results[BENCH_RESULTS_MAX];
+static int _result_count = 0;
+
+static double bench_now()
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Deterministic stream of coordinates, the same for every run and every build
+static unsigned int bench_random(unsigned int* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static int bench_compare(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+static World* bench_fill_board(int size)
+{
+    static const int types[] = { ECONOMY_TILE_GRASS, ECONOMY_TILE_FARM, ECONOMY_TILE_FOREST,
+                                 ECONOMY_TILE_HOUSE, ECONOMY_TILE_GRASS, ECONOMY_TILE_ROAD };
+    World* world = world_create(size, size);
+    if (world == nullptr) return nullptr;
+    for (int q = 0; q < size; ++q) {
+        for (int r = 0; r < size; ++r) {
+            world_add_tile(world, Tile{ .type = types[(q * 7 + r * 3) % 6] }, q, r);
+        }
+    }
+    return world;
+}
+
+// Board that fits the population with every tile taken
+static int bench_people_board(int people)
+{
+    int size = 7;
+    while (size * size < people) size *= 2;
+    return size;
+}
+
+static void bench_add_people(World* world, int people, int size)
+{
+    unsigned int seed = 1;
+    for (int i = 0; i < people; ++i) {
+        unsigned int value = bench_random(&seed);
+        world_add_person(world, 0, value % size, (value / size) % size);
+    }
+}
+
+static BenchSample bench_world_create(int size, int)
+{
+    double start = bench_now();
+    World* world = world_create(size, size);
+    double end = bench_now();
+    if (world == nullptr) return BENCH_FAILED;
+    world_destroy(world);
+    return BenchSample{ end - start, 1, (long long)size * size };
+}
+
+static BenchSample bench_world_add_tile(int size, int)
+{
+    double start = bench_now();
+    World* world = bench_fill_board(size);
+    double end = bench_now();
+    if (world == nullptr) return BENCH_FAILED;
+    world_destroy(world);
+    return BenchSample{ end - start, (long long)size * size, (long long)size * size };
+}
+
+static BenchSample bench_world_get_tile(int size, int)
+{
+    World* world = bench_fill_board(size);
+    if (world == nullptr) return BENCH_FAILED;
+    unsigned int seed = 7;
+    int found = 0;
+    double start = bench_now();
+    for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+        unsigned int value = bench_random(&seed);
+        Tile* t = world_get_tile(world, value % size, (value / size) % size);
+        found += t->type;
+    }
+    double end = bench_now();
+    world_destroy(world);
+    if (found == -1) printf("\n");      // Keeps the loop from being optimized away
+    return BenchSample{ end - start, BENCH_LOOKUPS, BENCH_LOOKUPS };
+}
+
+static BenchSample bench_world_update(int size, int)
+{
+    World* world = bench_fill_board(size);
+    if (world == nullptr) return BENCH_FAILED;
+    long long tiles = (long long)size * size;
+    int ticks = (tiles < BENCH_UPDATE_TILES) ? (int)(BENCH_UPDATE_TILES / tiles) : 1;
+    double start = bench_now();
+    for (int i = 0; i < ticks; ++i) {
+        world_update(world, 1.0f / 60);
+        world_clear_changes(world);
+    }
+    double end = bench_now();
+    world_destroy(world);
+    return BenchSample{ end - start, ticks, ticks * tiles };
+}
+
+static BenchSample bench_world_add_person(int size, int people)
+{
+    World* world = bench_fill_board(size);
+    if (world == nullptr) return BENCH_FAILED;
+    double start = bench_now();
+    bench_add_people(world, people, size);
+    double end = bench_now();
+    world_destroy(world);
+    return BenchSample{ end - start, people, people };
+}
+
+// A lookup scans the whole population, fewer lookups keep big populations bearable
+static BenchSample bench_world_get_person(int size, int people)
+{
+    World* world = bench_fill_board(size);
+    if (world == nullptr) return BENCH_FAILED;
+    bench_add_people(world, people, size);
+    int lookups = (people < BENCH_LOOKUPS / 16) ? BENCH_LOOKUPS / people : 16;
+    unsigned int seed = 11;
+    int found = 0;
+    double start = bench_now();
+    for (int i = 0; i < lookups; ++i) {
+        unsigned int value = bench_random(&seed);
+        if (world_get_person(world, value % size, (value / size) % size) != nullptr) ++found;
+    }
+    double end = bench_now();
+    world_destroy(world);
+    if (found == -1) printf("\n");
+    return BenchSample{ end - start, lookups, lookups };
+}
+
+static BenchSample bench_field_step(int size, int)
+{
+    Field field = { 0 };
+    int64_t before = memory_stats(MEMORY_TAG_WORLD).live_bytes;
+    if (!field_init(&field, size, size)) return BENCH_FAILED;
+    size_t bytes = (size_t)(memory_stats(MEMORY_TAG_WORLD).live_bytes - before);
+    for (int i = 0; i < size; ++i) field_set(&field, i, (i * 7) % size, 100.0f);
+    long long tiles = (long long)size * size;
+    int steps = (tiles < BENCH_UPDATE_TILES) ? (int)(BENCH_UPDATE_TILES / tiles) : 1;
+    double start = bench_now();
+    for (int i = 0; i < steps; ++i) field_step(&field, 0.1f, 0.01f);
+    double end = bench_now();
+    field_free(&field);
+    return BenchSample{ end - start, steps, steps * tiles, bytes };
+}
+
+typedef BenchSample (*BenchFunction)(int size, int people);
+
+static void bench_run(const BenchConfig* config, const char* name, BenchFunction function, int size, int people)
+{
+    if (config->filter != nullptr && strstr(name, config->filter) == nullptr) return;
+    if (_result_count >= BENCH_RESULTS_MAX) return;
+
+    double runs[BENCH_REPEAT_MAX] = { 0 };
+    BenchSample sample = { 0 };
+    for (int i = -config->warmup; i < config->repeat; ++i) {
+        sample = function(size, people);
+        if (sample.ops == 0) {
+            fprintf(stderr, "%s %dx%d %d people failed, skipped\n", name, size, size, people);
+            return;
+        }
+        if (i >= 0) runs[i] = sample.ns;
+    }
+    qsort(runs, config->repeat, sizeof(double), bench_compare);
+
+    // Whatever the world allocates, as counted by the memory tracker, 0 when there is no room for it
+    size_t world_bytes = 0;
+    int64_t before = memory_stats(MEMORY_TAG_WORLD).live_bytes;
+    World* world = world_create(size, size);
+    if (world != nullptr) {
+        world_bytes = (size_t)(memory_stats(MEMORY_TAG_WORLD).live_bytes - before);
+        world_destroy(world);
+    }
+
+    BenchResult* result = &_results[_result_count++];
+    result->name = name;
+    result->size = size;
+    result->people = people;
+    result->ops = sample.ops;
+    result->tiles = sample.tiles;
+    result->ns_min = runs[0];
+    result->ns_median = runs[config->repeat / 2];
+    result->bytes = (sample.bytes > 0) ? sample.bytes : world_bytes;
+
+    printf("%-20s %5dx%-5d %8d people %12.1f ns/op %14.0f tiles/s %12zu bytes\n", name, size, size, people,
+        result->ns_min / result->ops, result->tiles / (result->ns_min / 1.0e9), result->bytes);
+    fflush(stdout);
+}
+
+static bool bench_write_json(const char* filename, const BenchConfig* config)
+{
+    FILE* file = fopen(filename, "w");
+    if (file == nullptr) {
+        fprintf(stderr, "Can't write %s\n", filename);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"repeat\": %d,\n  \"warmup\": %d,\n  \"people_max\": %d,\n  \"benchmarks\": [\n",
+        config->repeat, config->warmup, PEOPLE_MAX);
+    for (int i = 0; i < _result_count; ++i) {
+        const BenchResult* r = &_results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"size\": %d, \"people\": %d, \"ops\": %lld, "
+            "\"ns_per_op\": %.3f, \"ns_per_op_median\": %.3f, \"tiles_per_second\": %.1f, \"bytes\": %zu}%s\n",
+            r->name, r->size, r->people, r->ops, r->ns_min / r->ops, r->ns_median / r->ops,
+            r->tiles / (r->ns_min / 1.0e9), r->bytes, (i + 1 < _result_count) ? "," : "");
+    }
+    fputs("  ]\n}\n", file);
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config = { 5, 1, 4096, 1000000, nullptr, nullptr };
+    for (int i = 1; i < argc; ++i) {
+        bool value = i + 1 < argc;
+        if (value && strcmp(argv[i], "--repeat") == 0) config.repeat = atoi(argv[++i]);
+        else if (value && strcmp(argv[i], "--warmup") == 0) config.warmup = atoi(argv[++i]);
+        else if (value && strcmp(argv[i], "--max-size") == 0) config.max_size = atoi(argv[++i]);
+        else if (value && strcmp(argv[i], "--max-people") == 0) config.max_people = atoi(argv[++i]);
+        else if (value && strcmp(argv[i], "--filter") == 0) config.filter = argv[++i];
+        else if (value && strcmp(argv[i], "--json") == 0) config.json = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--repeat n] [--warmup n] [--max-size n] [--max-people n] [--filter name] [--json file]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (config.repeat < 1) config.repeat = 1;
+    if (config.repeat > BENCH_REPEAT_MAX) config.repeat = BENCH_REPEAT_MAX;
+    config.warmup = (config.warmup > 0) ? config.warmup : 0;
+
+    // The world logs every placed tile
+    SetTraceLogLevel(LOG_WARNING);
+
+    for (int size : _board_sizes) {
+        if (size > config.max_size) continue;
+        bench_run(&config, "world_create", bench_world_create, size, 0);
+        bench_run(&config, "world_add_tile", bench_world_add_tile, size, 0);
+        bench_run(&config, "world_get_tile", bench_world_get_tile, size, 0);
+        bench_run(&config, "world_update", bench_world_update, size, 0);
+        bench_run(&config, "field_step", bench_field_step, size, 0);
+    }
+
+    for (int people : _populations) {
+        if (people > config.max_people || people > PEOPLE_MAX) continue;
+        int size = bench_people_board(people);
+        bench_run(&config, "world_add_person", bench_world_add_person, size, people);
+        bench_run(&config, "world_get_person", bench_world_get_person, size, people);
+    }
+
+    if (config.json != nullptr && !bench_write_json(config.json, &config)) return 1;
+    return 0;
+}
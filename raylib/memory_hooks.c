@@ -0,0 +1,31 @@
+/*
+Compiled into raylib when it is built from source, memory_hooks.h is forced into every raylib file
+and defines RL_MALLOC, RL_CALLOC, RL_REALLOC and RL_FREE to the functions below, see the root
+CMakeLists.txt. They use the C runtime until the game installs its own allocator with
+raylib_hook_install, see memory.hpp. Programs that never install one, like the tests and benchmarks,
+get plain malloc and free.
+*/
+
+#include "memory_hooks.h"
+
+#include <stdlib.h>
+
+static void* (*_malloc_hook)(size_t) = malloc;
+static void* (*_calloc_hook)(size_t, size_t) = calloc;
+static void* (*_realloc_hook)(void*, size_t) = realloc;
+static void (*_free_hook)(void*) = free;
+
+// Has to happen before raylib allocates anything, memory can't move between allocators
+void raylib_hook_install(void* (*malloc_hook)(size_t), void* (*calloc_hook)(size_t, size_t),
+    void* (*realloc_hook)(void*, size_t), void (*free_hook)(void*))
+{
+    _malloc_hook = malloc_hook;
+    _calloc_hook = calloc_hook;
+    _realloc_hook = realloc_hook;
+    _free_hook = free_hook;
+}
+
+void* raylib_hook_malloc(size_t size) { return _malloc_hook(size); }
+void* raylib_hook_calloc(size_t count, size_t size) { return _calloc_hook(count, size); }
+void* raylib_hook_realloc(void* ptr, size_t size) { return _realloc_hook(ptr, size); }
+void raylib_hook_free(void* ptr) { _free_hook(ptr); }
@@ -0,0 +1,23 @@
+#ifndef MEMORY_HOOKS_H
+#define MEMORY_HOOKS_H
+
+/*
+Forced into every raylib source file so its allocations go through memory_hooks.c
+*/
+
+#include <stddef.h>
+
+void raylib_hook_install(void* (*malloc_hook)(size_t), void* (*calloc_hook)(size_t, size_t),
+    void* (*realloc_hook)(void*, size_t), void (*free_hook)(void*));
+
+void* raylib_hook_malloc(size_t size);
+void* raylib_hook_calloc(size_t count, size_t size);
+void* raylib_hook_realloc(void* ptr, size_t size);
+void raylib_hook_free(void* ptr);
+
+#define RL_MALLOC(sz) raylib_hook_malloc(sz)
+#define RL_CALLOC(n, sz) raylib_hook_calloc(n, sz)
+#define RL_REALLOC(ptr, sz) raylib_hook_realloc(ptr, sz)
+#define RL_FREE(ptr) raylib_hook_free(ptr)
+
+#endif
@@ -0,0 +1,75 @@
+#include "arena.hpp"
+
+#include "raylib.h"
+
+#include <string.h>
+
+bool arena_init(Arena* arena, const char* name, size_t capacity, MemoryTag tag)
+{
+    *arena = Arena{ .name = name, .tag = tag };
+    capacity = arena_size(capacity);
+    // aligned_alloc doesn't zero and isn't on MSVC, so take a little more and align by hand
+    unsigned char* block = (unsigned char*)memory_calloc(tag, capacity + ARENA_ALIGN, 1);
+    if (block == nullptr) {
+        TraceLog(LOG_WARNING, "ARENA: Can't allocate %zu bytes for %s", capacity, name);
+        return false;
+    }
+    arena->block = block;
+    arena->base = block + (ARENA_ALIGN - (size_t)block % ARENA_ALIGN) % ARENA_ALIGN;
+    arena->capacity = capacity;
+    return true;
+}
+
+bool arena_init_sub(Arena* arena, const char* name, Arena* parent, size_t capacity)
+{
+    *arena = Arena{ .name = name, .tag = parent->tag };
+    capacity = arena_size(capacity);
+    arena->base = (unsigned char*)arena_alloc(parent, capacity);
+    if (arena->base == nullptr) return false;
+    arena->capacity = capacity;
+    return true;
+}
+
+void arena_free(Arena* arena)
+{
+    memory_free(arena->block);
+    arena->block = nullptr;
+    arena->base = nullptr;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+void* arena_alloc(Arena* arena, size_t bytes)
+{
+    bytes = arena_size(bytes);
+    if (arena->capacity - arena->used < bytes) {
+        TraceLog(LOG_WARNING, "ARENA: %s is out of space, %zu of %zu bytes used, %zu requested",
+            arena->name, arena->used, arena->capacity, bytes);
+        return nullptr;
+    }
+
+    unsigned char* result = arena->base + arena->used;
+    // Past the high water mark the memory was never handed out and is still zero
+    if (arena->used < arena->high_water) {
+        size_t dirty = arena->high_water - arena->used;
+        memset(result, 0, (dirty < bytes) ? dirty : bytes);
+    }
+    arena->used += bytes;
+    if (arena->used > arena->high_water) arena->high_water = arena->used;
+    return result;
+}
+
+void arena_reset(Arena* arena)
+{
+    arena->used = 0;
+}
+
+size_t arena_mark(const Arena* arena)
+{
+    return arena->used;
+}
+
+void arena_rewind(Arena* arena, size_t mark)
+{
+    if (mark < arena->used) arena->used = mark;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+Region allocator. An arena is one block that allocations are bumped out of, there is no way to free
+single allocations, the whole arena is released or reset at once. Sub-arenas carve a fixed part out of
+their parent so every subsystem has its own budget and statistics while the memory is still one block
+that goes away with a single free.
+
+Allocations are zeroed and aligned to ARENA_ALIGN. Memory that was never handed out is still zero from
+the initial calloc, so only the part below the high water mark has to be cleared again after a reset.
+*/
+
+#include "memory.hpp"
+
+#include <stddef.h>
+
+#define ARENA_ALIGN 64     // A cache line, arrays in different sub-arenas never share one
+
+struct Arena {
+    const char* name;
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+    size_t high_water;      // Most bytes ever used since arena_init
+    void* block;            // What arena_init allocated, nullptr for sub-arenas
+    MemoryTag tag;
+};
+
+// Bytes an allocation of bytes takes up, for sizing arenas up front
+constexpr size_t arena_size(size_t bytes)
+{
+    return (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+bool arena_init(Arena* arena, const char* name, size_t capacity, MemoryTag tag);
+// Takes capacity bytes out of parent, the sub-arena is released with it
+bool arena_init_sub(Arena* arena, const char* name, Arena* parent, size_t capacity);
+// Releases the block of an arena from arena_init, sub-arenas only forget theirs
+void arena_free(Arena* arena);
+
+// Zeroed memory or nullptr with a warning when the arena is full
+void* arena_alloc(Arena* arena, size_t bytes);
+// Forgets all allocations, the high water mark is kept
+void arena_reset(Arena* arena);
+// Forgets the allocations made since arena_mark returned mark, for temporaries
+size_t arena_mark(const Arena* arena);
+void arena_rewind(Arena* arena, size_t mark);
+
+#define ARENA_ALLOC(arena, type, count) ((type*)arena_alloc((arena), sizeof(type) * (size_t)(count)))
@@ -0,0 +1,204 @@
+#include "asset_cache.hpp"
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <stdint.h>
+#include <string.h>
+
+struct CachedTexture {
+    uint64_t hash;
+    int width;
+    int height;
+    int format;
+    int refs;
+    bool adopted;           // Loaded by raylib, there is no image to compare with
+    Texture texture;
+};
+
+struct CachedMaterial {
+    int refs;
+    Material material;
+};
+
+static CachedTexture _textures[TEXTURE_CACHE_MAX] = { 0 };
+static int _texture_count = 0;
+
+static CachedMaterial _materials[MATERIAL_CACHE_MAX] = { 0 };
+static int _material_count = 0;
+
+// FNV-1a over the pixel data
+static uint64_t image_hash(const Image* image)
+{
+    const unsigned char* bytes = (const unsigned char*)image->data;
+    int size = GetPixelDataSize(image->width, image->height, image->format);
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Reuses a released slot before growing, -1 when the cache is full
+static int texture_cache_slot()
+{
+    for (int i = 0; i < _texture_count; ++i) {
+        if (_textures[i].refs == 0) return i;
+    }
+    if (_texture_count >= TEXTURE_CACHE_MAX) return -1;
+    return _texture_count++;
+}
+
+Texture texture_cache_acquire(const Image* image)
+{
+    uint64_t hash = image_hash(image);
+    for (int i = 0; i < _texture_count; ++i) {
+        CachedTexture* t = &_textures[i];
+        if (t->refs > 0 && !t->adopted && t->hash == hash && t->width == image->width &&
+            t->height == image->height && t->format == image->format) {
+            ++t->refs;
+            return t->texture;
+        }
+    }
+
+    Texture texture = LoadTextureFromImage(*image);
+    if (texture.id == 0) return texture;
+
+    int slot = texture_cache_slot();
+    if (slot == -1) {
+        TraceLog(LOG_WARNING, "CACHE: Texture cache full, texture %d is not shared", texture.id);
+        return texture;
+    }
+
+    _textures[slot] = CachedTexture{ .hash = hash, .width = image->width, .height = image->height,
+        .format = image->format, .refs = 1, .texture = texture };
+    return texture;
+}
+
+void texture_cache_adopt(Texture texture)
+{
+    if (texture.id == 0 || texture.id == rlGetTextureIdDefault()) return;
+
+    // Materials of one model can use the same texture
+    for (int i = 0; i < _texture_count; ++i) {
+        if (_textures[i].refs > 0 && _textures[i].texture.id == texture.id) {
+            ++_textures[i].refs;
+            return;
+        }
+    }
+
+    int slot = texture_cache_slot();
+    if (slot == -1) {
+        TraceLog(LOG_WARNING, "CACHE: Texture cache full, texture %d is unloaded right away", texture.id);
+        UnloadTexture(texture);
+        return;
+    }
+    _textures[slot] = CachedTexture{ .refs = 1, .adopted = true, .texture = texture };
+}
+
+void texture_cache_release(Texture texture)
+{
+    if (texture.id == 0) return;
+    for (int i = 0; i < _texture_count; ++i) {
+        CachedTexture* t = &_textures[i];
+        if (t->refs > 0 && t->texture.id == texture.id) {
+            if (--t->refs == 0) UnloadTexture(t->texture);
+            return;
+        }
+    }
+}
+
+// Every map can hold a texture, the glb path only sets the diffuse one but raylib loads others
+static void material_release_textures(const Material* material)
+{
+    for (int i = 0; i < MAX_MATERIAL_MAPS; ++i) texture_cache_release(material->maps[i].texture);
+}
+
+static bool material_equal(const Material* a, const Material* b)
+{
+    return a->shader.id == b->shader.id &&
+        memcmp(a->maps, b->maps, MAX_MATERIAL_MAPS * sizeof(MaterialMap)) == 0 &&
+        memcmp(a->params, b->params, sizeof(a->params)) == 0;
+}
+
+Material material_cache_acquire(Material material)
+{
+    if (material.maps == nullptr) return material;
+
+    for (int i = 0; i < _material_count; ++i) {
+        CachedMaterial* m = &_materials[i];
+        if (m->refs > 0 && material_equal(&m->material, &material)) {
+            ++m->refs;
+            material_release_textures(&material);
+            MemFree(material.maps);
+            return m->material;
+        }
+    }
+
+    int slot = -1;
+    for (int i = 0; i < _material_count; ++i) {
+        if (_materials[i].refs == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == -1) {
+        if (_material_count >= MATERIAL_CACHE_MAX) {
+            TraceLog(LOG_WARNING, "CACHE: Material cache full, material is not shared");
+            return material;
+        }
+        slot = _material_count++;
+    }
+
+    _materials[slot] = CachedMaterial{ .refs = 1, .material = material };
+    return material;
+}
+
+void material_cache_release(Material material)
+{
+    if (material.maps == nullptr) return;
+
+    for (int i = 0; i < _material_count; ++i) {
+        CachedMaterial* m = &_materials[i];
+        if (m->refs > 0 && m->material.maps == material.maps) {
+            if (--m->refs == 0) {
+                material_release_textures(&m->material);
+                MemFree(m->material.maps);
+                m->material = Material{ 0 };
+            }
+            return;
+        }
+    }
+
+    // Not cached, the model owned it alone
+    material_release_textures(&material);
+    MemFree(material.maps);
+}
+
+void material_cache_rebind_shader(Shader from, Shader to)
+{
+    for (int i = 0; i < _material_count; ++i) {
+        if (_materials[i].refs > 0 && _materials[i].material.shader.id == from.id) {
+            _materials[i].material.shader = to;
+        }
+    }
+}
+
+int texture_cache_count()
+{
+    int count = 0;
+    for (int i = 0; i < _texture_count; ++i) {
+        if (_textures[i].refs > 0) ++count;
+    }
+    return count;
+}
+
+int material_cache_count()
+{
+    int count = 0;
+    for (int i = 0; i < _material_count; ++i) {
+        if (_materials[i].refs > 0) ++count;
+    }
+    return count;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/*
+Texture and material cache, all models are using the same colormap so identical images are only
+uploaded once and identical materials share one set of maps. Both caches are reference counted,
+every acquire or adopt has to be matched by a release.
+*/
+
+struct Image;
+struct Texture;
+struct Material;
+struct Shader;
+
+#define TEXTURE_CACHE_MAX 64
+#define MATERIAL_CACHE_MAX 128
+
+// Returns the texture for the contents of image, uploading it only if no identical image was seen before
+Texture texture_cache_acquire(const Image* image);
+
+// Takes over a texture that raylib loaded with a model, releasing it unloads it. It isn't shared with
+// images passed to texture_cache_acquire, the raylib default texture is ignored
+void texture_cache_adopt(Texture texture);
+
+// Textures that didn't come from the cache (e.g. the raylib default texture) are ignored
+void texture_cache_release(Texture texture);
+
+// Takes ownership of material (its maps and its references on cached textures), if an identical
+// material is already cached that one is returned and the passed in material is freed
+Material material_cache_acquire(Material material);
+
+void material_cache_release(Material material);
+
+// Switches every cached material using shader from to shader to
+void material_cache_rebind_shader(Shader from, Shader to);
+
+int texture_cache_count();
+int material_cache_count();
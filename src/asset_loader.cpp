@@ -0,0 +1,516 @@
+#include "asset_loader.hpp"
+#include "memory.hpp"
+#include "profiler.hpp"
+
+#include "raylib.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(PLATFORM_WEB)
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#define LOADER_MAX_THREADS 16
+
+struct LoadJob {
+    char path[LOADER_PATH_LENGTH];
+    bool decode_image;
+    int refs;
+#if defined(PLATFORM_WEB)
+    int state;
+#else
+    std::atomic<int> state;
+#endif
+    unsigned char* data;
+    int size;
+    Image image;
+};
+
+static LoadJob _jobs[LOADER_MAX_JOBS];
+
+// Ring of job ids waiting for a worker
+static int _queue[LOADER_MAX_JOBS];
+static int _queue_head = 0;
+static int _queue_count = 0;
+
+#if !defined(PLATFORM_WEB)
+static std::mutex _mutex;
+static std::condition_variable _wakeup;
+static std::thread _threads[LOADER_MAX_THREADS];
+static int _thread_count = 0;
+static bool _stopping = false;
+#endif
+
+unsigned char* loader_read_file(const char* path, int* size)
+{
+    *size = 0;
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) return nullptr;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    unsigned char* data = nullptr;
+    if (length > 0) {
+        // raylib frees the files handed to it through the load callback
+        data = (unsigned char*)MemAlloc((unsigned int)length);
+        if (data != nullptr && fread(data, 1, length, file) != (size_t)length) {
+            MemFree(data);
+            data = nullptr;
+        }
+    }
+    fclose(file);
+
+    if (data != nullptr) *size = (int)length;
+    return data;
+}
+
+static void loader_free_job(LoadJob* job)
+{
+    MemFree(job->data);
+    if (job->image.data != nullptr) UnloadImage(job->image);
+    job->data = nullptr;
+    job->size = 0;
+    job->image = Image{ 0 };
+    job->refs = 0;
+    job->state = LOAD_JOB_NONE;
+}
+
+static int loader_pop()
+{
+    if (_queue_count == 0) return -1;
+    int id = _queue[_queue_head];
+    _queue_head = (_queue_head + 1) % LOADER_MAX_JOBS;
+    --_queue_count;
+    return id;
+}
+
+// Does the actual work for a job, this is all cpu side and doesn't touch any raylib state
+static int loader_run_job(LoadJob* job)
+{
+    MEMORY_SCOPE(MEMORY_TAG_ASSETS);
+    job->data = loader_read_file(job->path, &job->size);
+    if (job->data == nullptr) return LOAD_JOB_FAILED;
+
+    if (job->decode_image) {
+        job->image = LoadImageFromMemory(GetFileExtension(job->path), job->data, job->size);
+        MemFree(job->data);
+        job->data = nullptr;
+        job->size = 0;
+        if (job->image.data == nullptr) return LOAD_JOB_FAILED;
+    }
+    return LOAD_JOB_DONE;
+}
+
+// Publishes the result of a job, jobs that were released while running are dropped here
+static void loader_finish_job(LoadJob* job, int state)
+{
+    if (job->refs == 0) loader_free_job(job);
+    else job->state = state;
+}
+
+#if !defined(PLATFORM_WEB)
+static void loader_worker()
+{
+    profile_thread_name("loader");
+    while (true) {
+        LoadJob* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeup.wait(lock, [] { return _stopping || _queue_count > 0; });
+            if (_stopping) return;
+            job = &_jobs[loader_pop()];
+            job->state = LOAD_JOB_RUNNING;
+        }
+        int state = 0;
+        {
+            PROFILE_ZONE("loader job");
+            state = loader_run_job(job);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        loader_finish_job(job, state);
+    }
+}
+#endif
+
+void loader_start(int thread_count)
+{
+#if !defined(PLATFORM_WEB)
+    if (_thread_count > 0) return;
+
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    if (thread_count > LOADER_MAX_THREADS) thread_count = LOADER_MAX_THREADS;
+
+    _stopping = false;
+    for (int i = 0; i < thread_count; ++i) {
+        _threads[i] = std::thread(loader_worker);
+    }
+    _thread_count = thread_count;
+    TraceLog(LOG_INFO, "LOADER: Started %d worker threads", thread_count);
+#endif
+}
+
+void loader_stop()
+{
+#if !defined(PLATFORM_WEB)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeup.notify_all();
+    for (int i = 0; i < _thread_count; ++i) {
+        _threads[i].join();
+    }
+    _thread_count = 0;
+#endif
+
+    for (int i = 0; i < LOADER_MAX_JOBS; ++i) {
+        loader_free_job(&_jobs[i]);
+    }
+    _queue_head = 0;
+    _queue_count = 0;
+}
+
+int loader_request(const char* path, bool decode_image)
+{
+#if !defined(PLATFORM_WEB)
+    std::unique_lock<std::mutex> lock(_mutex);
+#endif
+    int free_slot = -1;
+    for (int i = 0; i < LOADER_MAX_JOBS; ++i) {
+        if (_jobs[i].state == LOAD_JOB_NONE) {
+            if (free_slot == -1) free_slot = i;
+        }
+        else if (_jobs[i].decode_image == decode_image && strcmp(_jobs[i].path, path) == 0) {
+            ++_jobs[i].refs;
+            return i;
+        }
+    }
+
+    if (free_slot == -1) {
+        TraceLog(LOG_WARNING, "LOADER: Job table full, can't load %s", path);
+        return -1;
+    }
+
+    LoadJob* job = &_jobs[free_slot];
+    strncpy(job->path, path, LOADER_PATH_LENGTH - 1);
+    job->path[LOADER_PATH_LENGTH - 1] = '\0';
+    job->decode_image = decode_image;
+    job->refs = 1;
+    job->data = nullptr;
+    job->size = 0;
+    job->image = Image{ 0 };
+    job->state = LOAD_JOB_PENDING;
+
+    _queue[(_queue_head + _queue_count) % LOADER_MAX_JOBS] = free_slot;
+    ++_queue_count;
+
+#if !defined(PLATFORM_WEB)
+    lock.unlock();
+    _wakeup.notify_one();
+#endif
+    return free_slot;
+}
+
+void loader_release(int job)
+{
+    if (job < 0 || job >= LOADER_MAX_JOBS) return;
+#if !defined(PLATFORM_WEB)
+    std::lock_guard<std::mutex> lock(_mutex);
+#endif
+    LoadJob* j = &_jobs[job];
+    if (j->refs == 0) return;
+    if (--j->refs > 0) return;
+
+    // Still queued or running, the worker drops it once it's done
+    int state = j->state;
+    if (state == LOAD_JOB_PENDING || state == LOAD_JOB_RUNNING) return;
+    loader_free_job(j);
+}
+
+int loader_state(int job)
+{
+    if (job < 0 || job >= LOADER_MAX_JOBS) return LOAD_JOB_NONE;
+    return _jobs[job].state;
+}
+
+void loader_pump(double budget)
+{
+#if !defined(PLATFORM_WEB)
+    if (_thread_count > 0) return;
+#endif
+    double start = GetTime();
+    int id = loader_pop();
+    while (id != -1) {
+        LoadJob* job = &_jobs[id];
+        job->state = LOAD_JOB_RUNNING;
+        loader_finish_job(job, loader_run_job(job));
+        if (GetTime() - start > budget) break;
+        id = loader_pop();
+    }
+}
+
+int loader_completed(int* total)
+{
+    int count = 0;
+    int live = 0;
+    for (int i = 0; i < LOADER_MAX_JOBS; ++i) {
+        int state = _jobs[i].state;
+        if (state == LOAD_JOB_NONE) continue;
+        ++live;
+        if (state == LOAD_JOB_DONE || state == LOAD_JOB_FAILED) ++count;
+    }
+    if (total != nullptr) *total = live;
+    return count;
+}
+
+unsigned char* loader_take_data(int job, int* size)
+{
+    *size = 0;
+    if (loader_state(job) != LOAD_JOB_DONE) return nullptr;
+
+    unsigned char* data = _jobs[job].data;
+    *size = _jobs[job].size;
+    _jobs[job].data = nullptr;
+    _jobs[job].size = 0;
+    return data;
+}
+
+const Image* loader_get_image(int job)
+{
+    if (loader_state(job) != LOAD_JOB_DONE || _jobs[job].image.data == nullptr) return nullptr;
+    return &_jobs[job].image;
+}
+
+//----------------------------------------------------------------------------------
+// Minimal json reader, just enough to find the images used by the gltf materials
+//----------------------------------------------------------------------------------
+
+struct JsonCursor {
+    const char* p;
+    const char* end;
+};
+
+static void json_ws(JsonCursor* c)
+{
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\n' || *c->p == '\r' || *c->p == '\t')) ++c->p;
+}
+
+static bool json_expect(JsonCursor* c, char ch)
+{
+    json_ws(c);
+    if (c->p >= c->end || *c->p != ch) return false;
+    ++c->p;
+    return true;
+}
+
+// Returns the raw (still escaped) contents of a string
+static bool json_string(JsonCursor* c, const char** str, int* length)
+{
+    if (!json_expect(c, '"')) return false;
+    const char* start = c->p;
+    while (c->p < c->end && *c->p != '"') {
+        if (*c->p == '\\') ++c->p;
+        ++c->p;
+    }
+    if (c->p >= c->end) return false;
+    *str = start;
+    *length = (int)(c->p - start);
+    ++c->p;
+    return true;
+}
+
+// The json chunk isn't terminated, so the digits are read by hand and never past c->end
+static bool json_int(JsonCursor* c, int* value)
+{
+    json_ws(c);
+    bool negative = c->p < c->end && *c->p == '-';
+    if (negative) ++c->p;
+    if (c->p >= c->end || *c->p < '0' || *c->p > '9') return false;
+    long long v = 0;
+    while (c->p < c->end && *c->p >= '0' && *c->p <= '9') {
+        if (v <= INT_MAX) v = v * 10 + (*c->p - '0');
+        ++c->p;
+    }
+    if (v > INT_MAX) v = INT_MAX;
+    if (negative) v = -v;
+    // Skip fraction and exponent, indices are always integral
+    while (c->p < c->end && (*c->p == '.' || *c->p == 'e' || *c->p == 'E' || *c->p == '+' || *c->p == '-' ||
+        (*c->p >= '0' && *c->p <= '9'))) ++c->p;
+    *value = (int)v;
+    return true;
+}
+
+static bool json_skip(JsonCursor* c)
+{
+    json_ws(c);
+    if (c->p >= c->end) return false;
+
+    if (*c->p == '"') {
+        const char* s;
+        int length;
+        return json_string(c, &s, &length);
+    }
+    if (*c->p == '{' || *c->p == '[') {
+        int depth = 0;
+        while (c->p < c->end) {
+            char ch = *c->p;
+            if (ch == '"') {
+                const char* s;
+                int length;
+                if (!json_string(c, &s, &length)) return false;
+                continue;
+            }
+            if (ch == '{' || ch == '[') ++depth;
+            else if (ch == '}' || ch == ']') --depth;
+            ++c->p;
+            if (depth == 0) return true;
+        }
+        return false;
+    }
+    // Numbers, true, false, null
+    while (c->p < c->end && *c->p != ',' && *c->p != '}' && *c->p != ']') ++c->p;
+    return true;
+}
+
+// Steps to the next member of an object, c has to be just after the '{' or the previous value
+static bool json_next_member(JsonCursor* c, const char** key, int* key_length)
+{
+    json_ws(c);
+    if (c->p < c->end && *c->p == ',') ++c->p;
+    json_ws(c);
+    if (c->p >= c->end) return false;
+    if (*c->p == '}') {
+        ++c->p;
+        return false;
+    }
+    if (!json_string(c, key, key_length)) return false;
+    return json_expect(c, ':');
+}
+
+// Steps to the next element of an array, c has to be just after the '[' or the previous value
+static bool json_next_element(JsonCursor* c)
+{
+    json_ws(c);
+    if (c->p < c->end && *c->p == ',') ++c->p;
+    json_ws(c);
+    if (c->p >= c->end) return false;
+    if (*c->p == ']') {
+        ++c->p;
+        return false;
+    }
+    return true;
+}
+
+static bool json_key_is(const char* key, int length, const char* name)
+{
+    return (int)strlen(name) == length && strncmp(key, name, length) == 0;
+}
+
+// Finds member "name" in the object at c and reads it as an int
+static bool json_object_int(JsonCursor* c, const char* name, int* value)
+{
+    if (!json_expect(c, '{')) return false;
+    bool found = false;
+    const char* key;
+    int length;
+    while (json_next_member(c, &key, &length)) {
+        if (json_key_is(key, length, name)) found = json_int(c, value);
+        else if (!json_skip(c)) return false;
+    }
+    return found;
+}
+
+bool gltf_material_images(const unsigned char* data, int size, GltfImages* result)
+{
+    *result = GltfImages{ 0 };
+
+    // Binary gltf, 12 byte header followed by the json chunk
+    if (size < 20 || memcmp(data, "glTF", 4) != 0 || memcmp(data + 16, "JSON", 4) != 0) return false;
+    unsigned int json_length = 0;
+    memcpy(&json_length, data + 12, sizeof(json_length));
+    if (json_length > (unsigned int)size - 20) return false;
+
+    JsonCursor c = { (const char*)data + 20, (const char*)data + 20 + json_length };
+
+    int texture_source[GLTF_MAX_MATERIALS * 2];
+    int texture_count = 0;
+    int material_texture[GLTF_MAX_MATERIALS];
+
+    if (!json_expect(&c, '{')) return false;
+    const char* key;
+    int length;
+    while (json_next_member(&c, &key, &length)) {
+        if (json_key_is(key, length, "images")) {
+            if (!json_expect(&c, '[')) return false;
+            while (json_next_element(&c)) {
+                int index = result->image_count++;
+                if (!json_expect(&c, '{')) return false;
+                const char* member;
+                int member_length;
+                while (json_next_member(&c, &member, &member_length)) {
+                    const char* uri;
+                    int uri_length;
+                    if (json_key_is(member, member_length, "uri") && json_string(&c, &uri, &uri_length)) {
+                        if (index < GLTF_MAX_IMAGES && uri_length < LOADER_PATH_LENGTH) {
+                            memcpy(result->uris[index], uri, uri_length);
+                            result->uris[index][uri_length] = '\0';
+                        }
+                    }
+                    else if (!json_skip(&c)) return false;
+                }
+            }
+            if (result->image_count > GLTF_MAX_IMAGES) result->image_count = GLTF_MAX_IMAGES;
+        }
+        else if (json_key_is(key, length, "textures")) {
+            if (!json_expect(&c, '[')) return false;
+            while (json_next_element(&c)) {
+                int source = -1;
+                if (!json_object_int(&c, "source", &source)) source = -1;
+                if (texture_count < GLTF_MAX_MATERIALS * 2) texture_source[texture_count++] = source;
+            }
+        }
+        else if (json_key_is(key, length, "materials")) {
+            if (!json_expect(&c, '[')) return false;
+            while (json_next_element(&c)) {
+                int texture = -1;
+                if (!json_expect(&c, '{')) return false;
+                const char* member;
+                int member_length;
+                while (json_next_member(&c, &member, &member_length)) {
+                    if (json_key_is(member, member_length, "pbrMetallicRoughness")) {
+                        if (!json_expect(&c, '{')) return false;
+                        const char* pbr;
+                        int pbr_length;
+                        while (json_next_member(&c, &pbr, &pbr_length)) {
+                            if (json_key_is(pbr, pbr_length, "baseColorTexture")) {
+                                if (!json_object_int(&c, "index", &texture)) texture = -1;
+                            }
+                            else if (!json_skip(&c)) return false;
+                        }
+                    }
+                    else if (!json_skip(&c)) return false;
+                }
+                if (result->material_count < GLTF_MAX_MATERIALS) material_texture[result->material_count++] = texture;
+            }
+        }
+        else if (!json_skip(&c)) return false;
+    }
+
+    for (int i = 0; i < result->material_count; ++i) {
+        int texture = material_texture[i];
+        int image = (texture >= 0 && texture < texture_count) ? texture_source[texture] : -1;
+        bool external = image >= 0 && image < result->image_count && result->uris[image][0] != '\0';
+        result->material_image[i] = external ? image : -1;
+    }
+    return true;
+}
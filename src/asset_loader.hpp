@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+Asset loader, reads files from disk and decodes images on worker threads. The main thread
+requests files by path and polls for completion, gpu uploads always stay on the main thread.
+Jobs are reference counted, requesting a path that is still loaded returns the same job and
+every request has to be matched by a loader_release.
+
+On the web there are no worker threads, pending jobs are run by loader_pump instead.
+*/
+
+struct Image;
+
+#define LOADER_MAX_JOBS 512
+#define LOADER_PATH_LENGTH 256
+
+// Maximum number of materials/images that gltf_material_images can report for one file
+#define GLTF_MAX_MATERIALS 16
+#define GLTF_MAX_IMAGES 8
+
+enum LoadJobState {
+    LOAD_JOB_NONE = 0,
+    LOAD_JOB_PENDING,
+    LOAD_JOB_RUNNING,
+    LOAD_JOB_DONE,
+    LOAD_JOB_FAILED
+};
+
+// Start the worker threads, thread_count <= 0 uses one thread per core
+void loader_start(int thread_count);
+
+// Stop the workers and release every file and image that is still owned by the loader
+void loader_stop();
+
+// Queue a file for reading, if decode_image is set the file is also decoded into an Image
+// Returns the job id or -1 if the job table is full
+int loader_request(const char* path, bool decode_image);
+
+int loader_state(int job);
+
+// Run pending jobs on the calling thread until budget (in seconds) is used up,
+// only does work when no worker threads are running
+void loader_pump(double budget);
+
+// Drops one reference on the job, its data and image are freed once nobody holds it anymore
+void loader_release(int job);
+
+// Returns the number of jobs that are done or failed and the total number of live jobs
+int loader_completed(int* total);
+
+// Hands the raw file contents over to the caller, the data has to be released with MemFree()
+unsigned char* loader_take_data(int job, int* size);
+
+// Decoded image of a job, stays owned by the loader
+const Image* loader_get_image(int job);
+
+// Read a whole file into a buffer from MemAlloc, release it with MemFree(). Safe to call from any thread
+unsigned char* loader_read_file(const char* path, int* size);
+
+struct GltfImages {
+    int image_count;
+    char uris[GLTF_MAX_IMAGES][LOADER_PATH_LENGTH];
+    int material_count;
+    int material_image[GLTF_MAX_MATERIALS]; // index into uris for the base color, -1 if none
+};
+
+// Extract the external images used as base color by each material of a .glb file
+bool gltf_material_images(const unsigned char* data, int size, GltfImages* result);
@@ -1,9 +1,14 @@
 #include "assets.hpp"
+#include "asset_cache.hpp"
+#include "asset_loader.hpp"
+#include "memory.hpp"
+#include "model_manager.hpp"
+#include "render_queue.hpp"
 
 #include "raylib.h"
 
-#define RLIGHTS_IMPLEMENTATION
 #include "rlights.h"
+#include "shader_variants.hpp"
 
 #if defined(PLATFORM_DESKTOP)
 #define GLSL_VERSION            330
@@ -13,67 +18,331 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 
 static const char* _model_names[MODEL_COUNT] = {
 "hex/grass.glb",
 "hex/building-farm.glb",
 "hex/building-house.glb",
 "hex/grass-forest.glb",
-"people/character-female-f.glb"
+"people/character-female-f.glb",
+"hex/path-end.glb",
+"hex/path-straight.glb",
+"hex/path-corner-sharp.glb",
+"hex/path-corner.glb",
+"hex/path-intersectionA.glb",
+"hex/path-intersectionB.glb",
+"hex/path-intersectionC.glb",
+"hex/path-intersectionD.glb",
+"hex/path-intersectionE.glb",
+"hex/path-intersectionF.glb",
+"hex/path-intersectionG.glb",
+"hex/path-intersectionH.glb",
+"hex/path-crossing.glb",
+"hex/river-end.glb",
+"hex/river-straight.glb",
+"hex/river-corner-sharp.glb",
+"hex/river-corner.glb",
+"hex/river-intersectionA.glb",
+"hex/river-intersectionB.glb",
+"hex/river-intersectionC.glb",
+"hex/river-intersectionD.glb",
+"hex/river-intersectionE.glb",
+"hex/river-intersectionF.glb",
+"hex/river-intersectionG.glb",
+"hex/river-intersectionH.glb",
+"hex/river-crossing.glb",
 };
 
 static const char* resource_dir = "resources/";
 
 static const Vector3 Vector3Zero{ 0,0,0 };
 
-#define MAX_LIGHTS 4
-
 static Shader _lit_shader = { 0 };
-static Light _lights[MAX_LIGHTS] = { 0 };
+
+// Repeated meshes in the render queue are drawn with the instanced variant of the lit shader
+static void assets_bind_instancing()
+{
+#if !defined(PLATFORM_WEB)
+    render_queue_set_instanced_shader(_lit_shader, shader_variant_get(lighting_key(SHADER_FEATURE_INSTANCING)));
+#endif
+}
 
 static void assets_init_shaders() {
     if (_lit_shader.id != 0) return;
 
-    _lit_shader = LoadShader(TextFormat("resources/shaders/lighting.vs", GLSL_VERSION),
+    shader_variants_init(TextFormat("resources/shaders/lighting.vs", GLSL_VERSION),
         TextFormat("resources/shaders/lighting.fs", GLSL_VERSION));
-    // Get some required shader locations
-    _lit_shader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(_lit_shader, "viewPos");
-    // NOTE: "matModel" location name is automatically assigned on shader loading, 
-    // no need to get the location again if using that uniform name
-    //shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocation(shader, "matModel");
 
     // Ambient light level (some basic lighting)
-    int ambientLoc = GetShaderLocation(_lit_shader, "ambient");
-    float values[4] = {0.2f, 0.2f, 0.2f, 0.2f };
-    SetShaderValue(_lit_shader, ambientLoc, values, SHADER_UNIFORM_VEC4);
+    lighting_set_ambient(Vector4{ 0.2f, 0.2f, 0.2f, 0.2f });
 
     // Create lights
-    _lights[0] = CreateLight(LIGHT_DIRECTIONAL, Vector3 { 1, 1, 1 }, Vector3Zero, WHITE, _lit_shader);
-    //lights[1] = CreateLight(LIGHT_POINT, Vector3 { 2, 1, 2 }, Vector3Zero, RED, _lit_shader);
-    //lights[2] = CreateLight(LIGHT_POINT, Vector3 { -2, 1, 2 }, Vector3Zero, GREEN, _lit_shader);
-    //lights[3] = CreateLight(LIGHT_POINT, Vector3 { 2, 1, -2 }, Vector3Zero, BLUE, _lit_shader);
+    lighting_add(LIGHT_DIRECTIONAL, Vector3 { 1, 1, 1 }, Vector3Zero, WHITE);
+    //lighting_add(LIGHT_POINT, Vector3 { 2, 1, 2 }, Vector3Zero, RED);
+    //lighting_add(LIGHT_POINT, Vector3 { -2, 1, 2 }, Vector3Zero, GREEN);
+    //lighting_add(LIGHT_POINT, Vector3 { 2, 1, -2 }, Vector3Zero, BLUE);
+
+    // Only compile what the lights above need
+    _lit_shader = shader_variant_get(lighting_key(SHADER_FEATURE_NONE));
+    assets_bind_instancing();
 }
 
-Model* models_load(const char** names, const int count) {
+void assets_update_lighting()
+{
+    if (_lit_shader.id == 0) return;
+
+    Shader shader = shader_variant_get(lighting_key(SHADER_FEATURE_NONE));
+    if (shader.id == 0 || shader.id == _lit_shader.id) return;
+
+    material_cache_rebind_shader(_lit_shader, shader);
+    model_manager_rebind_shader(_lit_shader, shader);
+    _lit_shader = shader;
+    assets_bind_instancing();
+}
+
+void assets_unload_shaders()
+{
+    if (_lit_shader.id == 0) return;
+    shader_variants_unload();
+    _lit_shader = Shader{ 0 };
+}
+
+//----------------------------------------------------------------------------------
+// Background loading of single models
+//----------------------------------------------------------------------------------
+
+// File that LoadModel is going to ask for, handed over without touching the disk again
+static const char* _serve_path = nullptr;
+static unsigned char* _serve_data = nullptr;
+static int _serve_size = 0;
+
+static unsigned char* assets_serve_file(const char* fileName, int* dataSize)
+{
+    if (_serve_data != nullptr && strcmp(fileName, _serve_path) == 0) {
+        unsigned char* data = _serve_data;
+        *dataSize = _serve_size;
+        _serve_data = nullptr;
+        _serve_size = 0;
+        return data;
+    }
+
+    // Images were already decoded by the loader and are bound after LoadModel,
+    // returning nothing makes raylib skip its own decode and upload
+    if (IsFileExtension(fileName, ".png;.jpg;.jpeg")) {
+        *dataSize = 0;
+        return nullptr;
+    }
+
+    return loader_read_file(fileName, dataSize);
+}
+
+static void assets_release_images(ModelLoad* load)
+{
+    for (int i = 0; i < load->images.image_count; ++i) {
+        loader_release(load->image_jobs[i]);
+        load->image_jobs[i] = -1;
+    }
+    load->images.image_count = 0;
+}
+
+static Model assets_upload_model(ModelLoad* load)
+{
+    _serve_path = load->filename;
+    _serve_data = load->data;
+    _serve_size = load->size;
+    load->data = nullptr;
+    load->size = 0;
+
+    MEMORY_SCOPE(MEMORY_TAG_ASSETS);
+    SetLoadFileDataCallback(assets_serve_file);
+    Model model = LoadModel(load->filename);
+    SetLoadFileDataCallback(nullptr);
+
+    MemFree(_serve_data);
+    _serve_data = nullptr;
+    _serve_path = nullptr;
+
+    // Files that aren't binary gltf and images embedded in a glb are loaded by raylib, the cache takes
+    // their textures over so model_unload releases them like the ones uploaded below
+    for (int mat = 0; mat < model.materialCount; ++mat) {
+        for (int map = 0; map < MAX_MATERIAL_MAPS; ++map) texture_cache_adopt(model.materials[mat].maps[map].texture);
+    }
+
+    // raylib puts a default material at index 0, gltf material i is at i + 1
+    for (int mat = 1; mat < model.materialCount; ++mat) {
+        int image = (mat - 1 < load->images.material_count) ? load->images.material_image[mat - 1] : -1;
+        const Image* decoded = (image >= 0) ? loader_get_image(load->image_jobs[image]) : nullptr;
+        if (decoded != nullptr) {
+            model.materials[mat].maps[MATERIAL_MAP_DIFFUSE].texture = texture_cache_acquire(decoded);
+        }
+        model.materials[mat].shader = _lit_shader;
+    }
+
+    // Identical materials across models end up with the same maps, so switching
+    // between them while drawing doesn't change any state
+    for (int mat = 0; mat < model.materialCount; ++mat) {
+        model.materials[mat] = material_cache_acquire(model.materials[mat]);
+    }
+
+    assets_release_images(load);
+    return model;
+}
+
+// Once the model file is read, queue the images it references
+static void assets_scan_model(ModelLoad* load)
+{
+    load->data = loader_take_data(load->file_job, &load->size);
+    loader_release(load->file_job);
+    load->file_job = -1;
+
+    if (!gltf_material_images(load->data, load->size, &load->images)) {
+        // Not a binary gltf, raylib will load it including its images
+        load->images = GltfImages{ 0 };
+        return;
+    }
+
+    const char* directory = GetDirectoryPath(load->filename);
+    for (int i = 0; i < load->images.image_count; ++i) {
+        load->image_jobs[i] = -1;
+        if (load->images.uris[i][0] == '\0') continue;
+        load->image_jobs[i] = loader_request(TextFormat("%s/%s", directory, load->images.uris[i]), true);
+    }
+}
+
+static bool assets_images_done(const ModelLoad* load)
+{
+    for (int i = 0; i < load->images.image_count; ++i) {
+        int state = loader_state(load->image_jobs[i]);
+        if (state == LOAD_JOB_PENDING || state == LOAD_JOB_RUNNING) return false;
+    }
+    return true;
+}
+
+void model_load_begin(ModelLoad* load, const char* name)
+{
     assets_init_shaders();
-    Model* result = (Model*)calloc(count, sizeof(Model));
-    if (result == nullptr) return nullptr;
-    char buffer[1024];
-    
+    *load = ModelLoad{ 0 };
+    strncpy(load->filename, TextFormat("%s%s", resource_dir, name), LOADER_PATH_LENGTH - 1);
+    load->file_job = loader_request(load->filename, false);
+    load->state = (load->file_job == -1) ? MODEL_LOAD_FAILED : MODEL_LOAD_READING;
+}
+
+int model_load_poll(ModelLoad* load, bool upload, Model* model)
+{
+    if (load->state == MODEL_LOAD_READING) {
+        int state = loader_state(load->file_job);
+        if (state == LOAD_JOB_FAILED) {
+            TraceLog(LOG_WARNING, "ASSETS: Failed to read %s", load->filename);
+            model_load_cancel(load);
+            load->state = MODEL_LOAD_FAILED;
+            return load->state;
+        }
+        if (state != LOAD_JOB_DONE) return load->state;
+        assets_scan_model(load);
+        load->state = MODEL_LOAD_DECODING;
+    }
+
+    if (load->state == MODEL_LOAD_DECODING) {
+        if (!assets_images_done(load)) return load->state;
+        load->state = MODEL_LOAD_READY;
+    }
+
+    if (load->state == MODEL_LOAD_READY && upload) {
+        *model = assets_upload_model(load);
+        load->state = MODEL_LOAD_DONE;
+    }
+    return load->state;
+}
+
+void model_load_cancel(ModelLoad* load)
+{
+    loader_release(load->file_job);
+    load->file_job = -1;
+    assets_release_images(load);
+    MemFree(load->data);
+    load->data = nullptr;
+    load->size = 0;
+    load->state = MODEL_LOAD_NONE;
+}
+
+size_t model_memory_size(const Model* model)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < model->meshCount; ++i) {
+        const Mesh* mesh = &model->meshes[i];
+        size_t v = mesh->vertexCount;
+        size_t attributes = 0;
+        if (mesh->vertices != nullptr) attributes += v * 3 * sizeof(float);
+        if (mesh->texcoords != nullptr) attributes += v * 2 * sizeof(float);
+        if (mesh->texcoords2 != nullptr) attributes += v * 2 * sizeof(float);
+        if (mesh->normals != nullptr) attributes += v * 3 * sizeof(float);
+        if (mesh->tangents != nullptr) attributes += v * 4 * sizeof(float);
+        if (mesh->colors != nullptr) attributes += v * 4;
+        if (mesh->indices != nullptr) attributes += (size_t)mesh->triangleCount * 3 * sizeof(unsigned short);
+
+        // raylib keeps the cpu copy of everything that is uploaded
+        bytes += 2 * attributes;
+
+        if (mesh->animVertices != nullptr) bytes += v * 3 * sizeof(float);
+        if (mesh->animNormals != nullptr) bytes += v * 3 * sizeof(float);
+        if (mesh->boneIds != nullptr) bytes += v * 4;
+        if (mesh->boneWeights != nullptr) bytes += v * 4 * sizeof(float);
+    }
+    return bytes;
+}
+
+//----------------------------------------------------------------------------------
+// Model sets
+//----------------------------------------------------------------------------------
+
+// Loads all models and blocks until they are uploaded
+Model* models_load(const char** names, const int count) {
+    Model* result = (Model*)memory_calloc(MEMORY_TAG_ASSETS, count, sizeof(Model));
+    ModelLoad* loads = (ModelLoad*)memory_calloc(MEMORY_TAG_ASSETS, count, sizeof(ModelLoad));
+    if (result == nullptr || loads == nullptr) {
+        memory_free(result);
+        memory_free(loads);
+        return nullptr;
+    }
+
+    loader_start(0);
     for (int i = 0; i < count; ++i) {
-        const char* filename = TextFormat("resources/%s", names[i]);
-        result[i] = LoadModel(filename);
-        for (int mat = 1; mat < result[i].materialCount; ++mat) {
-            result[i].materials[mat].shader = _lit_shader;
+        model_load_begin(&loads[i], names[i]);
+    }
+
+    int remaining = count;
+    while (remaining > 0) {
+        loader_pump(1.0);
+        remaining = 0;
+        for (int i = 0; i < count; ++i) {
+            int state = model_load_poll(&loads[i], true, &result[i]);
+            if (state != MODEL_LOAD_DONE && state != MODEL_LOAD_FAILED) ++remaining;
         }
+        if (remaining > 0) WaitTime(0.001);
     }
+
+    memory_free(loads);
     return result;
 }
 
+// Materials and textures are shared between models, they are released through the cache
+// and UnloadModel is left with just the meshes
+void model_unload(Model* model) {
+    for (int mat = 0; mat < model->materialCount; ++mat) {
+        material_cache_release(model->materials[mat]);
+    }
+    MemFree(model->materials);
+    model->materials = nullptr;
+    model->materialCount = 0;
+    UnloadModel(*model);
+}
+
 void models_unload(Model* models, const int count) {
     for (int i = 0; i < count; ++i) {
-        UnloadModel(models[i]);
+        model_unload(&models[i]);
     }
+    memory_free(models);
 }
 
 Model* models_load_all()
@@ -81,4 +350,17 @@ Model* models_load_all()
     return models_load(_model_names, MODEL_COUNT);
 }
 
+const char* model_path(int type)
+{
+    if (type < 0 || type >= MODEL_COUNT) return nullptr;
+    return TextFormat("%s%s", resource_dir, _model_names[type]);
+}
 
+void models_register_all()
+{
+    // The built in models go first so that their handles match BuildingType
+    for (int i = 0; i < MODEL_COUNT; ++i) {
+        model_manager_register(_model_names[i]);
+    }
+    model_manager_register_list(TextFormat("%shex/names.txt", resource_dir), "hex/");
+}
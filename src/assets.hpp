@@ -5,6 +5,10 @@ Assets, this is responsible for managing the assets of the games, these are all
  
 */
 
+#include "asset_loader.hpp"
+
+#include <stddef.h>
+
 struct Model;
 
 enum BuildingType {
@@ -14,6 +18,33 @@ enum BuildingType {
     MODEL_BUILDING_HOUSE,
     MODEL_BUILDING_FOREST,
     MODEL_CHARACTER_FEMALE,
+    // Auto tiled roads and rivers, in the order of AutoTileShape
+    MODEL_PATH_END,
+    MODEL_PATH_STRAIGHT,
+    MODEL_PATH_CORNER_SHARP,
+    MODEL_PATH_CORNER,
+    MODEL_PATH_INTERSECTION_A,
+    MODEL_PATH_INTERSECTION_B,
+    MODEL_PATH_INTERSECTION_C,
+    MODEL_PATH_INTERSECTION_D,
+    MODEL_PATH_INTERSECTION_E,
+    MODEL_PATH_INTERSECTION_F,
+    MODEL_PATH_INTERSECTION_G,
+    MODEL_PATH_INTERSECTION_H,
+    MODEL_PATH_CROSSING,
+    MODEL_RIVER_END,
+    MODEL_RIVER_STRAIGHT,
+    MODEL_RIVER_CORNER_SHARP,
+    MODEL_RIVER_CORNER,
+    MODEL_RIVER_INTERSECTION_A,
+    MODEL_RIVER_INTERSECTION_B,
+    MODEL_RIVER_INTERSECTION_C,
+    MODEL_RIVER_INTERSECTION_D,
+    MODEL_RIVER_INTERSECTION_E,
+    MODEL_RIVER_INTERSECTION_F,
+    MODEL_RIVER_INTERSECTION_G,
+    MODEL_RIVER_INTERSECTION_H,
+    MODEL_RIVER_CROSSING,
     MODEL_COUNT
 };
 
@@ -21,7 +52,51 @@ Model* models_load_all();
 
 Model* models_load(const char** names, const int count);
 
+// Unloads the models and frees the array that models_load returned
 void models_unload(Model* models, const int count);
+void model_unload(Model* model);
+
+// Call after changing the scene lights, switches all models to the shader variant that fits them
+void assets_update_lighting();
+
+// Unloads every compiled shader variant, call after the models that use them are gone
+void assets_unload_shaders();
+
+// Path of a built in model relative to the working directory, from TextFormat
+const char* model_path(int type);
+
+// Registers every known model with the model manager, the handles of the
+// built in models are their BuildingType
+void models_register_all();
+
+enum ModelLoadState {
+    MODEL_LOAD_NONE = 0,
+    MODEL_LOAD_READING,     // Waiting for the file
+    MODEL_LOAD_DECODING,    // Waiting for the images it uses
+    MODEL_LOAD_READY,       // Everything is in memory, can be uploaded
+    MODEL_LOAD_DONE,
+    MODEL_LOAD_FAILED
+};
+
+// Loading of a single model in the background, the file read and image decoding are done by
+// the loader's worker threads, the gpu upload happens in model_load_poll on the main thread
+struct ModelLoad {
+    char filename[LOADER_PATH_LENGTH];
+    int state;
+    int file_job;
+    unsigned char* data;
+    int size;
+    GltfImages images;
+    int image_jobs[GLTF_MAX_IMAGES];
+};
+
+void model_load_begin(ModelLoad* load, const char* name);
 
+// Advances the load and returns its state, the model is only uploaded if upload is set.
+// Once the state is MODEL_LOAD_DONE the model has been written to *model
+int model_load_poll(ModelLoad* load, bool upload, Model* model);
 
+void model_load_cancel(ModelLoad* load);
 
+// Bytes used by the meshes of a model, textures are shared and not included
+size_t model_memory_size(const Model* model);
@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+Auto tiling for roads and rivers. Every connecting tile keeps a 6 bit mask of the neighbors it connects
+to, a table built at compile time maps that mask to one of the path/river shapes and the rotation that
+lines the shape up with the neighbors. Bit i of a mask is the edge towards hex_directions[i].
+
+Placing or replacing a tile only re-evaluates that tile and its six neighbors.
+*/
+
+#include "hex.hpp"
+
+// Has to be in the same order as the path and river models in BuildingType
+enum AutoTileShape {
+    AUTOTILE_END,
+    AUTOTILE_STRAIGHT,
+    AUTOTILE_CORNER_SHARP,
+    AUTOTILE_CORNER,
+    AUTOTILE_INTERSECTION_A,
+    AUTOTILE_INTERSECTION_B,
+    AUTOTILE_INTERSECTION_C,
+    AUTOTILE_INTERSECTION_D,
+    AUTOTILE_INTERSECTION_E,
+    AUTOTILE_INTERSECTION_F,
+    AUTOTILE_INTERSECTION_G,
+    AUTOTILE_INTERSECTION_H,
+    AUTOTILE_CROSSING,
+    AUTOTILE_SHAPE_COUNT
+};
+
+// Edges connected by each shape when the model is not rotated, measured from the kenney hex models
+constexpr unsigned int autotile_shape_edges[AUTOTILE_SHAPE_COUNT] = {
+    0b001000,   // end
+    0b001001,   // straight
+    0b011000,   // corner-sharp
+    0b101000,   // corner
+    0b111000,   // intersectionA
+    0b101001,   // intersectionB
+    0b001011,   // intersectionC
+    0b101011,   // intersectionD
+    0b011011,   // intersectionE
+    0b101010,   // intersectionF
+    0b111011,   // intersectionG
+    0b111001,   // intersectionH
+    0b111111,   // crossing
+};
+
+struct AutoTile {
+    unsigned char shape;
+    unsigned char rotation;     // In steps of 60 degrees, as Tile::rotation
+};
+
+// Drawing a model rotated by rotation steps moves its edge i to edge i - rotation
+constexpr unsigned int autotile_rotate(unsigned int mask, int rotation)
+{
+    unsigned int result = 0;
+    for (int i = 0; i < 6; ++i) {
+        if (mask & (1u << i)) result |= 1u << ((i - rotation + 6) % 6);
+    }
+    return result;
+}
+
+struct AutoTileTable {
+    AutoTile tiles[64];
+    bool complete;
+};
+
+constexpr AutoTileTable autotile_build_table()
+{
+    AutoTileTable table = {};
+    table.complete = true;
+    for (unsigned int mask = 0; mask < 64; ++mask) {
+        bool found = (mask == 0);   // A tile without neighbors is drawn as an unrotated end
+        for (int shape = 0; shape < AUTOTILE_SHAPE_COUNT && !found; ++shape) {
+            for (int rotation = 0; rotation < 6 && !found; ++rotation) {
+                if (autotile_rotate(autotile_shape_edges[shape], rotation) != mask) continue;
+                table.tiles[mask] = AutoTile{ (unsigned char)shape, (unsigned char)rotation };
+                found = true;
+            }
+        }
+        table.complete = table.complete && found;
+    }
+    return table;
+}
+
+constexpr AutoTileTable autotile_table = autotile_build_table();
+static_assert(autotile_table.complete, "Every neighbor mask needs a shape");
+
+constexpr AutoTile autotile_lookup(unsigned int mask)
+{
+    return autotile_table.tiles[mask & 0x3f];
+}
@@ -0,0 +1,256 @@
+#include "bitboard.hpp"
+#include "memory.hpp"
+
+#include "raylib.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <bit>
+
+static int bitboard_word_count(const Bitboard* board)
+{
+    return board->max_q * board->words_per_row;
+}
+
+// Mask of the bits of the last word of a row that are on the board
+static uint64_t bitboard_tail_mask(const Bitboard* board)
+{
+    int bits = board->max_r % 64;
+    return (bits == 0) ? ~0ull : (1ull << bits) - 1;
+}
+
+static bool bitboard_setup(Bitboard* board, int max_q, int max_r, uint64_t* words)
+{
+    board->max_q = max_q;
+    board->max_r = max_r;
+    board->words_per_row = (max_r + 63) / 64;
+    board->words = words;
+    if (board->words == nullptr) {
+        TraceLog(LOG_WARNING, "BITBOARD: Can't allocate %dx%d", max_q, max_r);
+        board->max_q = 0;
+        board->max_r = 0;
+        return false;
+    }
+    return true;
+}
+
+bool bitboard_init(Bitboard* board, int max_q, int max_r)
+{
+    return bitboard_setup(board, max_q, max_r, (uint64_t*)memory_calloc(MEMORY_TAG_WORLD, bitboard_size(max_q, max_r), 1));
+}
+
+bool bitboard_init_arena(Bitboard* board, int max_q, int max_r, Arena* arena)
+{
+    return bitboard_setup(board, max_q, max_r, (uint64_t*)arena_alloc(arena, bitboard_size(max_q, max_r)));
+}
+
+void bitboard_free(Bitboard* board)
+{
+    memory_free(board->words);
+    board->words = nullptr;
+    board->max_q = 0;
+    board->max_r = 0;
+}
+
+size_t bitboard_bytes(const Bitboard* board)
+{
+    return (size_t)bitboard_word_count(board) * sizeof(uint64_t);
+}
+
+size_t bitboard_size(int max_q, int max_r)
+{
+    return (size_t)max_q * ((max_r + 63) / 64) * sizeof(uint64_t);
+}
+
+void bitboard_clear(Bitboard* board)
+{
+    memset(board->words, 0, bitboard_bytes(board));
+}
+
+void bitboard_set(Bitboard* board, int q, int r, bool value)
+{
+    if (q < 0 || q >= board->max_q || r < 0 || r >= board->max_r) return;
+    uint64_t* word = &board->words[q * board->words_per_row + r / 64];
+    uint64_t bit = 1ull << (r % 64);
+    *word = value ? (*word | bit) : (*word & ~bit);
+}
+
+bool bitboard_get(const Bitboard* board, int q, int r)
+{
+    if (q < 0 || q >= board->max_q || r < 0 || r >= board->max_r) return false;
+    return (board->words[q * board->words_per_row + r / 64] >> (r % 64)) & 1;
+}
+
+void bitboard_copy(Bitboard* dst, const Bitboard* src)
+{
+    memcpy(dst->words, src->words, bitboard_bytes(src));
+}
+
+void bitboard_and(Bitboard* dst, const Bitboard* a, const Bitboard* b)
+{
+    int count = bitboard_word_count(dst);
+    for (int i = 0; i < count; ++i) dst->words[i] = a->words[i] & b->words[i];
+}
+
+void bitboard_or(Bitboard* dst, const Bitboard* a, const Bitboard* b)
+{
+    int count = bitboard_word_count(dst);
+    for (int i = 0; i < count; ++i) dst->words[i] = a->words[i] | b->words[i];
+}
+
+void bitboard_andn(Bitboard* dst, const Bitboard* a, const Bitboard* b)
+{
+    int count = bitboard_word_count(dst);
+    for (int i = 0; i < count; ++i) dst->words[i] = a->words[i] & ~b->words[i];
+}
+
+int bitboard_count(const Bitboard* board)
+{
+    int count = bitboard_word_count(board);
+    int total = 0;
+    for (int i = 0; i < count; ++i) total += std::popcount(board->words[i]);
+    return total;
+}
+
+bool bitboard_any(const Bitboard* board)
+{
+    int count = bitboard_word_count(board);
+    for (int i = 0; i < count; ++i) {
+        if (board->words[i] != 0) return true;
+    }
+    return false;
+}
+
+// Row shifted towards higher r by one, bit r of the result is bit r - 1 of the row
+static inline uint64_t bitboard_row_up(const uint64_t* row, int w)
+{
+    return (row[w] << 1) | ((w > 0) ? row[w - 1] >> 63 : 0);
+}
+
+// Row shifted towards lower r by one, bit r of the result is bit r + 1 of the row
+static inline uint64_t bitboard_row_down(const uint64_t* row, int w, int words)
+{
+    return (row[w] >> 1) | ((w + 1 < words) ? row[w + 1] << 63 : 0);
+}
+
+// The neighbors of q/r are q+1/r, q-1/r, q/r+1, q/r-1, q-1/r+1 and q+1/r-1, so row q of the result
+// is row q spread both ways, row q-1 with itself shifted down and row q+1 with itself shifted up
+static void bitboard_dilate_rows(Bitboard* dst, const Bitboard* src, int q0, int q1)
+{
+    int words = src->words_per_row;
+    uint64_t tail = bitboard_tail_mask(src);
+    for (int q = q0; q <= q1; ++q) {
+        const uint64_t* row = &src->words[q * words];
+        const uint64_t* prev = (q > 0) ? row - words : nullptr;
+        const uint64_t* next = (q + 1 < src->max_q) ? row + words : nullptr;
+        uint64_t* out = &dst->words[q * words];
+        for (int w = 0; w < words; ++w) {
+            uint64_t bits = row[w] | bitboard_row_up(row, w) | bitboard_row_down(row, w, words);
+            if (prev != nullptr) bits |= prev[w] | bitboard_row_down(prev, w, words);
+            if (next != nullptr) bits |= next[w] | bitboard_row_up(next, w);
+            out[w] = bits;
+        }
+        out[words - 1] &= tail;
+    }
+}
+
+void bitboard_dilate(Bitboard* dst, const Bitboard* src)
+{
+    bitboard_dilate_rows(dst, src, 0, src->max_q - 1);
+}
+
+void bitboard_dilate_n(Bitboard* dst, const Bitboard* src, int radius, Bitboard* scratch)
+{
+    // Alternates between dst and scratch, never reading and writing the same board
+    const Bitboard* from = src;
+    for (int i = 0; i < radius; ++i) {
+        Bitboard* to = (from == dst) ? scratch : dst;
+        bitboard_dilate(to, from);
+        from = to;
+    }
+    if (from != dst) bitboard_copy(dst, from);
+}
+
+// Grows the fill by one ring per pass until nothing is added. Only the rows the fill has reached and
+// the ones next to them are visited, dst has to be empty. Rows lo to hi of dst hold the result
+static void bitboard_fill(Bitboard* dst, const Bitboard* mask, int q, int r, Bitboard* scratch, int* lo, int* hi)
+{
+    *lo = q;
+    *hi = q - 1;
+    if (!bitboard_get(mask, q, r)) return;
+    bitboard_set(dst, q, r, true);
+    *hi = q;
+
+    int words = dst->words_per_row;
+    bool grown = true;
+    while (grown) {
+        int q0 = (*lo > 0) ? *lo - 1 : 0;
+        int q1 = (*hi + 1 < dst->max_q) ? *hi + 1 : dst->max_q - 1;
+        bitboard_dilate_rows(scratch, dst, q0, q1);
+        grown = false;
+        for (int row = q0; row <= q1; ++row) {
+            bool any = false;
+            for (int w = row * words; w < (row + 1) * words; ++w) {
+                uint64_t bits = scratch->words[w] & mask->words[w];
+                if (bits != dst->words[w]) grown = true;
+                if (bits != 0) any = true;
+                dst->words[w] = bits;
+            }
+            if (any && row < *lo) *lo = row;
+            if (any && row > *hi) *hi = row;
+        }
+    }
+}
+
+void bitboard_flood_fill(Bitboard* dst, const Bitboard* mask, int q, int r, Bitboard* scratch)
+{
+    int lo = 0;
+    int hi = 0;
+    bitboard_clear(dst);
+    bitboard_fill(dst, mask, q, r, scratch, &lo, &hi);
+}
+
+int bitboard_components(const Bitboard* mask, int* labels, Arena* arena)
+{
+    int tiles = mask->max_q * mask->max_r;
+    for (int i = 0; i < tiles; ++i) labels[i] = -1;
+
+    size_t mark = arena_mark(arena);
+    Bitboard left = { 0 };
+    Bitboard component = { 0 };
+    Bitboard scratch = { 0 };
+    if (!bitboard_init_arena(&left, mask->max_q, mask->max_r, arena) ||
+        !bitboard_init_arena(&component, mask->max_q, mask->max_r, arena) ||
+        !bitboard_init_arena(&scratch, mask->max_q, mask->max_r, arena))
+    {
+        arena_rewind(arena, mark);
+        return 0;
+    }
+    bitboard_copy(&left, mask);
+
+    int count = 0;
+    int words = left.words_per_row;
+    for (int i = 0; i < bitboard_word_count(&left); ++i) {
+        while (left.words[i] != 0) {
+            int lo = 0;
+            int hi = 0;
+            bitboard_fill(&component, &left, i / words, (i % words) * 64 + std::countr_zero(left.words[i]), &scratch, &lo, &hi);
+
+            for (int j = lo * words; j < (hi + 1) * words; ++j) {
+                uint64_t bits = component.words[j];
+                left.words[j] &= ~bits;
+                component.words[j] = 0;
+                while (bits != 0) {
+                    int bit = std::countr_zero(bits);
+                    bits &= bits - 1;
+                    labels[(j / words) * left.max_r + (j % words) * 64 + bit] = count;
+                }
+            }
+            ++count;
+        }
+    }
+
+    arena_rewind(arena, mark);
+    return count;
+}
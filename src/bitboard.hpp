@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+Bitboards, one bit per hex of the board. Every q is a row of max_r bits padded to whole 64 bit words,
+so the operations below work on 64 hexes at a time. The world keeps one board per TileType, questions
+like "farms within 3 hexes of a house" become a few dilations and an AND over the whole board:
+
+    bitboard_dilate_n(&near, &world->layers[ECONOMY_TILE_HOUSE], 3, &scratch);
+    bitboard_and(&near, &near, &world->layers[ECONOMY_TILE_FARM]);
+    int farms = bitboard_count(&near);
+
+All boards in one operation need the same dimensions, the destination may be one of the sources unless
+noted otherwise.
+*/
+
+#include "arena.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct Bitboard {
+    int max_q;
+    int max_r;
+    int words_per_row;
+    uint64_t* words;        // max_q * words_per_row, bits past max_r are always 0
+};
+
+bool bitboard_init(Bitboard* board, int max_q, int max_r);
+// The words come from arena and go away with it, don't bitboard_free these boards
+bool bitboard_init_arena(Bitboard* board, int max_q, int max_r, Arena* arena);
+void bitboard_free(Bitboard* board);
+size_t bitboard_bytes(const Bitboard* board);
+// Bytes of the words of a max_q by max_r board
+size_t bitboard_size(int max_q, int max_r);
+
+void bitboard_clear(Bitboard* board);
+void bitboard_set(Bitboard* board, int q, int r, bool value);
+bool bitboard_get(const Bitboard* board, int q, int r);
+
+void bitboard_copy(Bitboard* dst, const Bitboard* src);
+void bitboard_and(Bitboard* dst, const Bitboard* a, const Bitboard* b);
+void bitboard_or(Bitboard* dst, const Bitboard* a, const Bitboard* b);
+// a and not b
+void bitboard_andn(Bitboard* dst, const Bitboard* a, const Bitboard* b);
+int bitboard_count(const Bitboard* board);
+bool bitboard_any(const Bitboard* board);
+
+// Adds the six neighbors of every set hex, dst can't be src
+void bitboard_dilate(Bitboard* dst, const Bitboard* src);
+// Everything within radius steps, scratch is a board of the same size that gets overwritten
+void bitboard_dilate_n(Bitboard* dst, const Bitboard* src, int radius, Bitboard* scratch);
+
+// Hexes of mask connected to q/r through neighbors that are in mask, empty if q/r isn't in mask.
+// dst can't be mask
+void bitboard_flood_fill(Bitboard* dst, const Bitboard* mask, int q, int r, Bitboard* scratch);
+
+#define BITBOARD_COMPONENTS_BOARDS 3    // Temporary boards bitboard_components takes out of scratch
+
+// Writes the component of every hex into labels (tile index order, q * max_r + r), -1 for hexes that
+// aren't in mask. Returns the number of components. The temporary boards come from scratch, which is
+// rewound before returning
+int bitboard_components(const Bitboard* mask, int* labels, Arena* scratch);
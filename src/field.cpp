@@ -0,0 +1,235 @@
+#include "field.hpp"
+#include "memory.hpp"
+#include "hex.hpp"
+
+#include "raylib.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(PLATFORM_WEB)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+static size_t field_buffer_floats(const Field* field)
+{
+    return (size_t)(field->max_q + 2) * field->stride;
+}
+
+// First hex of row q
+static inline float* field_row(const Field* field, int buffer, int q)
+{
+    return field->cells[buffer] + (size_t)(q + 1) * field->stride + 1;
+}
+
+// The row blocks of one step, the caller takes block 0 and worker i block i
+struct FieldJob {
+    Field* field;
+    float keep;
+    float spread;
+    int blocks;
+};
+
+static void field_step_rows(Field* field, int q0, int q1, float keep, float spread);
+
+static void field_step_block(const FieldJob* job, int block)
+{
+    int max_q = job->field->max_q;
+    field_step_rows(job->field, max_q * block / job->blocks, max_q * (block + 1) / job->blocks, job->keep, job->spread);
+}
+
+#if !defined(PLATFORM_WEB)
+static std::mutex _mutex;
+static std::condition_variable _start;
+static std::condition_variable _done;
+static std::mutex _step_mutex;          // One threaded step at a time
+static std::thread _threads[FIELD_THREADS_MAX];
+static int _thread_count = 0;
+static int _users = 0;                  // Threaded fields, the workers stop with the last one
+static unsigned int _generation = 0;    // Incremented for every step the workers take part in
+static int _pending = 0;
+static bool _quit = false;
+static FieldJob _job = { 0 };
+
+// seen is the generation when the worker was started, it only takes part in later steps
+static void field_worker(int block, unsigned int seen)
+{
+    for (;;) {
+        FieldJob job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start.wait(lock, [&] { return _quit || _generation != seen; });
+            if (_quit) return;
+            seen = _generation;
+            job = _job;
+        }
+        if (block < job.blocks) field_step_block(&job, block);
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_pending == 0) _done.notify_one();
+    }
+}
+
+// Starts the workers for the first threaded field, returns false when there is only one core
+static bool field_workers_acquire()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_users == 0) {
+        int threads = (int)std::thread::hardware_concurrency();
+        if (threads > FIELD_THREADS_MAX) threads = FIELD_THREADS_MAX;
+        if (threads < 2) return false;
+        _quit = false;
+        _thread_count = threads - 1;
+        for (int i = 0; i < _thread_count; ++i) _threads[i] = std::thread(field_worker, i + 1, _generation);
+    }
+    ++_users;
+    return true;
+}
+
+static void field_workers_release()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_users > 0) return;
+        _quit = true;
+    }
+    _start.notify_all();
+    for (int i = 0; i < _thread_count; ++i) _threads[i].join();
+    _thread_count = 0;
+}
+#endif
+
+bool field_init(Field* field, int max_q, int max_r)
+{
+    field->threaded = false;
+    field->max_q = max_q;
+    field->max_r = max_r;
+    field->stride = (max_r + 2 + 7) & ~7;
+    field->current = 0;
+    field->cells[0] = (float*)memory_calloc(MEMORY_TAG_WORLD, field_buffer_floats(field), sizeof(float));
+    field->cells[1] = (float*)memory_calloc(MEMORY_TAG_WORLD, field_buffer_floats(field), sizeof(float));
+    if (field->cells[0] == nullptr || field->cells[1] == nullptr) {
+        TraceLog(LOG_WARNING, "FIELD: Can't allocate %dx%d", max_q, max_r);
+        field_free(field);
+        return false;
+    }
+#if !defined(PLATFORM_WEB)
+    if ((size_t)max_q * max_r >= FIELD_PARALLEL_CELLS) field->threaded = field_workers_acquire();
+#endif
+    return true;
+}
+
+void field_free(Field* field)
+{
+#if !defined(PLATFORM_WEB)
+    if (field->threaded) field_workers_release();
+#endif
+    field->threaded = false;
+    memory_free(field->cells[0]);
+    memory_free(field->cells[1]);
+    field->cells[0] = nullptr;
+    field->cells[1] = nullptr;
+    field->max_q = 0;
+    field->max_r = 0;
+}
+
+size_t field_bytes(const Field* field)
+{
+    return 2 * field_buffer_floats(field) * sizeof(float);
+}
+
+float field_sample(const Field* field, int q, int r)
+{
+    if (q < 0 || q >= field->max_q || r < 0 || r >= field->max_r) return 0.0f;
+    return field_row(field, field->current, q)[r];
+}
+
+void field_set(Field* field, int q, int r, float value)
+{
+    if (q < 0 || q >= field->max_q || r < 0 || r >= field->max_r) return;
+    field_row(field, field->current, q)[r] = value;
+}
+
+void field_add(Field* field, int q, int r, float amount)
+{
+    if (q < 0 || q >= field->max_q || r < 0 || r >= field->max_r) return;
+    field_row(field, field->current, q)[r] += amount;
+}
+
+// Ghost columns copy the first and last hex of their row, the ghost rows copy the first and last row
+static void field_fill_ghosts(Field* field)
+{
+    for (int q = 0; q < field->max_q; ++q) {
+        float* row = field_row(field, field->current, q);
+        row[-1] = row[0];
+        row[field->max_r] = row[field->max_r - 1];
+    }
+    float* cells = field->cells[field->current];
+    memcpy(cells, cells + field->stride, field->stride * sizeof(float));
+    memcpy(cells + (size_t)(field->max_q + 1) * field->stride, cells + (size_t)field->max_q * field->stride,
+        field->stride * sizeof(float));
+}
+
+// The neighbors of q/r are r +- 1 in the same row, r and r + 1 in row q - 1 and r and r - 1 in row q + 1.
+// keep scales the hex itself and spread the sum of its neighbors
+static void field_step_rows(Field* field, int q0, int q1, float keep, float spread)
+{
+    int stride = field->stride;
+    int max_r = field->max_r;
+    for (int q = q0; q < q1; ++q) {
+        const float* c = field_row(field, field->current, q);
+        const float* up = c - stride;
+        const float* down = c + stride;
+        float* out = field_row(field, 1 - field->current, q);
+
+        int r = 0;
+#if defined(HEX_SSE2)
+        const __m128 k = _mm_set1_ps(keep);
+        const __m128 s = _mm_set1_ps(spread);
+        for (; r + 4 <= max_r; r += 4) {
+            __m128 sum = _mm_add_ps(_mm_loadu_ps(c + r - 1), _mm_loadu_ps(c + r + 1));
+            sum = _mm_add_ps(sum, _mm_add_ps(_mm_loadu_ps(up + r), _mm_loadu_ps(up + r + 1)));
+            sum = _mm_add_ps(sum, _mm_add_ps(_mm_loadu_ps(down + r), _mm_loadu_ps(down + r - 1)));
+            _mm_storeu_ps(out + r, _mm_add_ps(_mm_mul_ps(k, _mm_loadu_ps(c + r)), _mm_mul_ps(s, sum)));
+        }
+#endif
+        for (; r < max_r; ++r) {
+            float sum = (c[r - 1] + c[r + 1]) + (up[r] + up[r + 1]) + (down[r] + down[r - 1]);
+            out[r] = keep * c[r] + spread * sum;
+        }
+    }
+}
+
+void field_step(Field* field, float diffusion, float decay)
+{
+    if (field->cells[0] == nullptr) return;
+    if (diffusion < 0.0f) diffusion = 0.0f;
+    if (diffusion > 1.0f / 6) diffusion = 1.0f / 6;
+
+    float keep = (1.0f - decay) * (1.0f - 6 * diffusion);
+    float spread = (1.0f - decay) * diffusion;
+    field_fill_ghosts(field);
+
+    FieldJob job = { field, keep, spread, 1 };
+#if !defined(PLATFORM_WEB)
+    if (field->threaded) {
+        std::lock_guard<std::mutex> step(_step_mutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            job.blocks = (_thread_count + 1 < field->max_q) ? _thread_count + 1 : field->max_q;
+            _job = job;
+            _pending = _thread_count;
+            ++_generation;
+        }
+        _start.notify_all();
+        field_step_block(&job, 0);
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [] { return _pending == 0; });
+    }
+    else
+#endif
+    field_step_block(&job, 0);
+
+    field->current = 1 - field->current;
+}
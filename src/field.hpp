@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+Scalar fields on the hex grid for things that spread, like fertility, pollution or desirability. Every
+hex has one float, the rows are surrounded by a ghost border so the 7 point stencil of a hex and its six
+neighbors never has to check the board bounds. Before a step the ghosts copy the edge of the board, so
+little leaks out over the border.
+
+Stepping reads one buffer and writes the other, SSE2 handles four hexes at a time and big fields are
+split over threads by rows. The threads start with the first big field and wait for steps until the
+last one is freed, a step only wakes them. Every hex only depends on the previous step so the result is
+the same with any number of threads.
+*/
+
+#include <stddef.h>
+
+#define FIELD_THREADS_MAX 8
+#define FIELD_PARALLEL_CELLS (1 << 18)  // Smaller fields aren't worth waking threads for
+
+struct Field {
+    int max_q;
+    int max_r;
+    int stride;             // Floats per row, max_r plus the ghosts rounded up to 8
+    float* cells[2];        // max_q + 2 rows each, hex q/r is at (q + 1) * stride + r + 1
+    int current;            // Buffer with the latest values
+    bool threaded;          // Big enough to step on the worker threads
+};
+
+bool field_init(Field* field, int max_q, int max_r);
+void field_free(Field* field);
+size_t field_bytes(const Field* field);
+
+// Reading outside of the board gives 0, writing there is ignored
+float field_sample(const Field* field, int q, int r);
+void field_set(Field* field, int q, int r, float value);
+void field_add(Field* field, int q, int r, float amount);
+
+// One step of diffusion, every hex moves diffusion of its value to each neighbor and then loses decay
+// of it. diffusion is clamped to 1/6 where all of a hex would flow out. Threaded fields take turns when
+// they are stepped from several threads at once
+void field_step(Field* field, float diffusion, float decay);
@@ -0,0 +1,22 @@
+#include "format.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+int format_append(char* buffer, int size, int* length, const char* format, ...)
+{
+    if (buffer == nullptr || size <= 0 || *length >= size - 1) return 0;
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + *length, size - *length, format, args);
+    va_end(args);
+
+    if (written < 0) {
+        buffer[*length] = '\0';
+        return 0;
+    }
+    if (written > size - 1 - *length) written = size - 1 - *length;
+    *length += written;
+    return written;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+/*
+Reentrant text formatting into caller owned buffers. Unlike TextFormat/TextAppend there is no shared
+static buffer, so it is safe to use from any thread, and nothing is allocated.
+*/
+
+// Appends to buffer at *length like snprintf and advances *length, returns the number of characters
+// written. The result is truncated to size - 1 characters and always terminated
+int format_append(char* buffer, int size, int* length, const char* format, ...);
@@ -0,0 +1,90 @@
+#include "frame_pacing.hpp"
+
+#include "raylib.h"
+
+// Rate at which updates keep running while nothing is drawn
+static const double idleInterval = 1.0/60.0;
+
+#if defined(PLATFORM_WEB)
+static bool _enabled = false;   // The browser drives the loop, always draw
+#else
+static bool _enabled = true;
+#endif
+
+static unsigned int _reasons = REDRAW_WINDOW;
+static unsigned int _last_reasons = REDRAW_NONE;
+static double _last_time = 0.0;
+static float _frame_time = 0.0f;
+static int _skipped = 0;
+static bool _focused = true;
+
+void pacing_set_enabled(bool on_demand)
+{
+#if !defined(PLATFORM_WEB)
+    _enabled = on_demand;
+#endif
+    _reasons |= REDRAW_WINDOW;
+}
+
+bool pacing_enabled()
+{
+    return _enabled;
+}
+
+void pacing_begin_frame()
+{
+    double now = GetTime();
+    _frame_time = (_last_time > 0.0) ? (float)(now - _last_time) : GetFrameTime();
+    _last_time = now;
+
+    // Mouse movement can change hover state of the gui
+    Vector2 delta = GetMouseDelta();
+    if (delta.x != 0.0f || delta.y != 0.0f || GetMouseWheelMove() != 0.0f) _reasons |= REDRAW_INPUT;
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) || IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) _reasons |= REDRAW_INPUT;
+
+    bool focused = IsWindowFocused();
+    if (IsWindowResized() || focused != _focused) _reasons |= REDRAW_WINDOW;
+    _focused = focused;
+}
+
+float pacing_frame_time()
+{
+    return _frame_time;
+}
+
+void pacing_invalidate(unsigned int reasons)
+{
+    _reasons |= reasons;
+}
+
+bool pacing_should_draw()
+{
+    return !_enabled || _reasons != REDRAW_NONE;
+}
+
+void pacing_frame_drawn()
+{
+    _last_reasons = _reasons;
+    _reasons = REDRAW_NONE;
+    _skipped = 0;
+}
+
+void pacing_idle()
+{
+    // EndDrawing usually does this, nothing was presented so the frame limiter
+    // didn't run either
+    ++_skipped;
+    PollInputEvents();
+    double remaining = idleInterval - (GetTime() - _last_time);
+    if (remaining > 0.0) WaitTime(remaining);
+}
+
+unsigned int pacing_last_reasons()
+{
+    return _last_reasons;
+}
+
+int pacing_skipped_frames()
+{
+    return _skipped;
+}
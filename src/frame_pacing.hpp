@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+Frame pacing, redraws only happen when something on screen changed. Systems report changes through
+pacing_invalidate, when nothing did the frame isn't drawn at all and the last presented image stays
+on screen. Updates keep running at the same rate either way, pacing_frame_time measures the real
+time between updates so the simulation doesn't depend on frames being drawn.
+*/
+
+enum RedrawReason {
+    REDRAW_NONE = 0,
+    REDRAW_CAMERA = 1 << 0,
+    REDRAW_INPUT = 1 << 1,
+    REDRAW_WORLD = 1 << 2,
+    REDRAW_PEOPLE = 1 << 3,
+    REDRAW_HUD = 1 << 4,
+    REDRAW_STREAMING = 1 << 5,
+    REDRAW_WINDOW = 1 << 6,
+    REDRAW_ALWAYS = 1 << 7,     // Screen is animated, e.g. the logo or a transition
+};
+
+void pacing_set_enabled(bool on_demand);
+bool pacing_enabled();
+
+// Call at the start of every update, measures the frame time and picks up window and mouse changes
+void pacing_begin_frame();
+
+// Seconds since the previous update, whether or not that frame was drawn
+float pacing_frame_time();
+
+void pacing_invalidate(unsigned int reasons);
+
+bool pacing_should_draw();
+
+// The frame was drawn and presented, clears all reasons
+void pacing_frame_drawn();
+
+// Instead of drawing, poll input and sleep until the next update is due
+void pacing_idle();
+
+// Reasons that caused the last drawn frame, for debugging
+unsigned int pacing_last_reasons();
+
+// Number of frames that were skipped since the last drawn one
+int pacing_skipped_frames();
@@ -0,0 +1,267 @@
+#include "heatmap.hpp"
+#include "memory.hpp"
+#include "world.hpp"
+#include "hex.hpp"
+
+#include "rlgl.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// A hex is a center vertex and six corners
+#define HEATMAP_HEX_VERTICES 7
+#define HEATMAP_HEX_TRIANGLES 6
+
+// Vertex buffer index of the colors in a raylib mesh
+#define HEATMAP_BUFFER_COLORS 3
+
+// Slightly above the top of the tiles
+#define HEATMAP_HEIGHT 0.22f
+
+// Half of the steps the world reports supply changes in, smaller moves keep the color
+#define HEATMAP_THRESHOLD (0.5f / SUPPLY_LEVELS)
+
+// dirty_min of a chunk without dirty tiles
+#define HEATMAP_CLEAN (HEATMAP_CHUNK * HEATMAP_CHUNK)
+
+struct HeatmapChunk {
+    Mesh mesh;
+    int q0;
+    int r0;
+    int count_r;                // Tiles along r, the slot of a tile is (q - q0)*count_r + r - r0
+    int dirty_min;              // Range of slots to upload, dirty_max < dirty_min when clean
+    int dirty_max;
+};
+
+static HeatmapChunk* _chunks = nullptr;
+static int _chunks_q = 0;
+static int _chunks_r = 0;
+static float* _values = nullptr;    // Value each tile was last colored with, < 0 for no value
+static int* _dirty = nullptr;       // Chunks that need an upload
+static int _dirty_count = 0;
+static int _tile_count = 0;
+static Material _material = { 0 };
+
+static bool _enabled = false;
+static int _metric = HEATMAP_SUPPLY;
+static int _good = 0;
+
+static float heatmap_value(const World* world, const Tile* t)
+{
+    int stock = world_find_stock(world, t, _good);
+    if (stock < 0) return -1.0f;
+
+    const Stock* s = &world->stocks[stock];
+    switch (_metric) {
+    case HEATMAP_SUPPLY:
+        if (s->supply_max <= 0) return -1.0f;
+        return (float)s->supply / (float)s->supply_max;
+    case HEATMAP_UNMET_DEMAND: {
+        Quantity demand = world->stock_info[stock].demand;
+        if (demand <= 0) return -1.0f;
+        float covered = (float)s->supply / ((float)demand * HEATMAP_DEMAND_SECONDS);
+        return 1.0f - ((covered < 1.0f) ? covered : 1.0f);
+    }
+    }
+    return -1.0f;
+}
+
+// Blue for low values to red for high ones, tiles without a value are invisible
+static Color heatmap_color(float value)
+{
+    if (value < 0) return Color{ 0, 0, 0, 0 };
+    if (value > 1) value = 1;
+    return Color{ (unsigned char)(255 * value), (unsigned char)(80 * (1 - fabsf(value * 2 - 1))),
+                  (unsigned char)(255 * (1 - value)), 160 };
+}
+
+static void heatmap_build_chunk(HeatmapChunk* chunk, int count_q, Vector3 origin, float size)
+{
+    MEMORY_SCOPE(MEMORY_TAG_RENDER);
+    int tiles = count_q * chunk->count_r;
+    Mesh* mesh = &chunk->mesh;
+    mesh->vertexCount = tiles * HEATMAP_HEX_VERTICES;
+    mesh->triangleCount = tiles * HEATMAP_HEX_TRIANGLES;
+    mesh->vertices = (float*)MemAlloc(mesh->vertexCount * 3 * sizeof(float));
+    mesh->colors = (unsigned char*)MemAlloc(mesh->vertexCount * 4);
+    mesh->indices = (unsigned short*)MemAlloc(mesh->triangleCount * 3 * sizeof(unsigned short));
+
+    Hex hexes[HEATMAP_CHUNK * HEATMAP_CHUNK];
+    Vector3 centers[HEATMAP_CHUNK * HEATMAP_CHUNK];
+    for (int slot = 0; slot < tiles; ++slot) {
+        hexes[slot] = Hex{ chunk->q0 + slot / chunk->count_r, chunk->r0 + slot % chunk->count_r };
+    }
+    hex_to_world_batch(hexes, tiles, size, Vector3{ origin.x, origin.y + HEATMAP_HEIGHT, origin.z }, centers);
+
+    for (int slot = 0; slot < tiles; ++slot) {
+        float* v = &mesh->vertices[slot * HEATMAP_HEX_VERTICES * 3];
+        v[0] = centers[slot].x;
+        v[1] = centers[slot].y;
+        v[2] = centers[slot].z;
+        for (int i = 0; i < 6; ++i) {
+            v[(i + 1)*3 + 0] = centers[slot].x + size * hex_corners[i].x;
+            v[(i + 1)*3 + 1] = centers[slot].y;
+            v[(i + 1)*3 + 2] = centers[slot].z + size * hex_corners[i].y;
+        }
+
+        // Wound so the triangles face up
+        unsigned short base = (unsigned short)(slot * HEATMAP_HEX_VERTICES);
+        unsigned short* index = &mesh->indices[slot * HEATMAP_HEX_TRIANGLES * 3];
+        for (int i = 0; i < 6; ++i) {
+            index[i*3 + 0] = base;
+            index[i*3 + 1] = (unsigned short)(base + 1 + (i + 1) % 6);
+            index[i*3 + 2] = (unsigned short)(base + 1 + i);
+        }
+    }
+    for (int i = 0; i < mesh->vertexCount * 4; ++i) mesh->colors[i] = 0;
+
+    UploadMesh(mesh, true);
+    chunk->dirty_min = HEATMAP_CLEAN;
+    chunk->dirty_max = -1;
+}
+
+void heatmap_init(const World* world, Vector3 origin, float size)
+{
+    heatmap_unload();
+
+    _chunks_q = (world->max_q + HEATMAP_CHUNK - 1) / HEATMAP_CHUNK;
+    _chunks_r = (world->max_r + HEATMAP_CHUNK - 1) / HEATMAP_CHUNK;
+    _tile_count = world->tile_count;
+    _chunks = (HeatmapChunk*)memory_calloc(MEMORY_TAG_RENDER, _chunks_q * _chunks_r, sizeof(HeatmapChunk));
+    _dirty = (int*)memory_calloc(MEMORY_TAG_RENDER, _chunks_q * _chunks_r, sizeof(int));
+    _values = (float*)memory_calloc(MEMORY_TAG_RENDER, _tile_count, sizeof(float));
+    if (_chunks == nullptr || _dirty == nullptr || _values == nullptr) {
+        TraceLog(LOG_WARNING, "HEATMAP: Can't allocate %dx%d chunks", _chunks_q, _chunks_r);
+        heatmap_unload();
+        return;
+    }
+    for (int i = 0; i < _tile_count; ++i) _values[i] = -1.0f;
+    _material = LoadMaterialDefault();
+
+    for (int cq = 0; cq < _chunks_q; ++cq) {
+        for (int cr = 0; cr < _chunks_r; ++cr) {
+            HeatmapChunk* chunk = &_chunks[cq * _chunks_r + cr];
+            chunk->q0 = cq * HEATMAP_CHUNK;
+            chunk->r0 = cr * HEATMAP_CHUNK;
+            int count_q = (world->max_q - chunk->q0 < HEATMAP_CHUNK) ? world->max_q - chunk->q0 : HEATMAP_CHUNK;
+            chunk->count_r = (world->max_r - chunk->r0 < HEATMAP_CHUNK) ? world->max_r - chunk->r0 : HEATMAP_CHUNK;
+            heatmap_build_chunk(chunk, count_q, origin, size);
+        }
+    }
+}
+
+void heatmap_unload()
+{
+    for (int i = 0; _chunks != nullptr && i < _chunks_q * _chunks_r; ++i) {
+        UnloadMesh(_chunks[i].mesh);
+    }
+    if (_material.maps != nullptr) UnloadMaterial(_material);
+    _material = Material{ 0 };
+    memory_free(_chunks);
+    memory_free(_dirty);
+    memory_free(_values);
+    _chunks = nullptr;
+    _dirty = nullptr;
+    _values = nullptr;
+    _chunks_q = 0;
+    _chunks_r = 0;
+    _dirty_count = 0;
+    _tile_count = 0;
+}
+
+// Writes the color of one tile into its chunk, returns true if it changed
+static bool heatmap_color_tile(const World* world, int index, bool force)
+{
+    float value = heatmap_value(world, &world->tiles[index]);
+    float last = _values[index];
+    bool visible_changed = (value < 0) != (last < 0);
+    if (!force && !visible_changed && fabsf(value - last) <= HEATMAP_THRESHOLD) return false;
+    _values[index] = value;
+
+    int q = index / world->max_r;
+    int r = index % world->max_r;
+    int c = (q / HEATMAP_CHUNK) * _chunks_r + r / HEATMAP_CHUNK;
+    HeatmapChunk* chunk = &_chunks[c];
+    int slot = (q - chunk->q0) * chunk->count_r + (r - chunk->r0);
+
+    Color color = heatmap_color(value);
+    unsigned char* colors = &chunk->mesh.colors[slot * HEATMAP_HEX_VERTICES * 4];
+    for (int i = 0; i < HEATMAP_HEX_VERTICES; ++i) {
+        colors[i*4 + 0] = color.r;
+        colors[i*4 + 1] = color.g;
+        colors[i*4 + 2] = color.b;
+        colors[i*4 + 3] = color.a;
+    }
+
+    if (chunk->dirty_max < chunk->dirty_min) _dirty[_dirty_count++] = c;
+    if (slot < chunk->dirty_min) chunk->dirty_min = slot;
+    if (slot > chunk->dirty_max) chunk->dirty_max = slot;
+    return true;
+}
+
+static void heatmap_upload()
+{
+    const int stride = HEATMAP_HEX_VERTICES * 4;
+    for (int i = 0; i < _dirty_count; ++i) {
+        HeatmapChunk* chunk = &_chunks[_dirty[i]];
+        int offset = chunk->dirty_min * stride;
+        int bytes = (chunk->dirty_max - chunk->dirty_min + 1) * stride;
+        UpdateMeshBuffer(chunk->mesh, HEATMAP_BUFFER_COLORS, chunk->mesh.colors + offset, bytes, offset);
+        chunk->dirty_min = HEATMAP_CLEAN;
+        chunk->dirty_max = -1;
+    }
+    _dirty_count = 0;
+}
+
+static void heatmap_refresh(const World* world)
+{
+    if (_chunks == nullptr) return;
+    for (int i = 0; i < _tile_count; ++i) heatmap_color_tile(world, i, true);
+    heatmap_upload();
+}
+
+bool heatmap_set_enabled(const World* world, bool enabled)
+{
+    if (enabled == _enabled) return false;
+    if (enabled) heatmap_refresh(world);
+    _enabled = enabled;
+    return true;
+}
+
+bool heatmap_set_metric(const World* world, int metric, int good)
+{
+    if (metric == _metric && good == _good) return false;
+    _metric = metric;
+    _good = good;
+    if (_enabled) heatmap_refresh(world);
+    return true;
+}
+
+bool heatmap_enabled()
+{
+    return _enabled;
+}
+
+int heatmap_update(const World* world)
+{
+    if (!_enabled || _chunks == nullptr) return 0;
+
+    int count = 0;
+    for (int i = 0; i < world->change_count; ++i) {
+        if (heatmap_color_tile(world, world->changes[i], false)) ++count;
+    }
+    heatmap_upload();
+    return count;
+}
+
+void heatmap_draw()
+{
+    if (!_enabled || _chunks == nullptr) return;
+
+    // Transparent, so it must not hide anything drawn after it
+    rlDisableDepthMask();
+    for (int i = 0; i < _chunks_q * _chunks_r; ++i) {
+        DrawMesh(_chunks[i].mesh, _material, MatrixIdentity());
+    }
+    rlEnableDepthMask();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+Heatmap overlay, colors every hex by a metric of one good. The board is split into chunks, each chunk
+is a single vertex colored mesh so the whole overlay is a handful of draws. When the world changes only
+the colors of the tiles in world->changes are rewritten, with one partial vertex buffer update per chunk.
+
+The world only reports a tile once its supply crosses one of SUPPLY_LEVELS steps, so the overlay follows
+supply in those steps and not any finer. Tiles that moved less than half a step since they were last
+colored, going back and forth over a step boundary, keep their color.
+*/
+
+#include "raylib.h"
+
+struct World;
+
+#define HEATMAP_CHUNK 16            // Chunks are HEATMAP_CHUNK x HEATMAP_CHUNK tiles
+#define HEATMAP_DEMAND_SECONDS 10.0f // Demand counts as met with this many seconds of stock
+
+enum HeatmapMetric {
+    HEATMAP_SUPPLY,             // supply / supplyMax
+    HEATMAP_UNMET_DEMAND,       // How far the stock is from covering the demand, empty until a recipe has demand
+    HEATMAP_METRIC_COUNT
+};
+
+// The overlay is laid out like hex_to_world(hex, size) + origin
+void heatmap_init(const World* world, Vector3 origin, float size);
+void heatmap_unload();
+
+// Turning the overlay on or changing the metric recolors every tile once, both return true on a change
+bool heatmap_set_enabled(const World* world, bool enabled);
+bool heatmap_set_metric(const World* world, int metric, int good);
+bool heatmap_enabled();
+
+// Recolors the tiles in world->changes, returns the number of tiles that got a new color
+int heatmap_update(const World* world);
+
+// Has to be called inside BeginMode3D after the opaque geometry
+void heatmap_draw();
@@ -0,0 +1,195 @@
+#pragma once
+
+/*
+Hex grid math, header only and without allocations. Coordinates are axial (q, r), the cube form adds
+s = -q - r for the algorithms that are simpler in three dimensions. The board uses pointy topped hexes
+laid out on the xz plane, see https://www.redblobgames.com/grids/hexagons/ for the background.
+
+Everything on single hexes is constexpr. hex_to_world_batch and hex_transforms_batch convert whole
+arrays at once, four hexes per step with SSE2 where it is available.
+*/
+
+#include "raylib.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HEX_SSE2
+#include <emmintrin.h>
+#endif
+
+#define HEX_SQRT3 1.73205080757f
+
+struct Hex {
+    int q;
+    int r;
+};
+
+struct HexCube {
+    int q;
+    int r;
+    int s;
+};
+
+constexpr bool operator==(Hex a, Hex b) { return a.q == b.q && a.r == b.r; }
+constexpr bool operator!=(Hex a, Hex b) { return !(a == b); }
+constexpr Hex operator+(Hex a, Hex b) { return Hex{ a.q + b.q, a.r + b.r }; }
+constexpr Hex operator-(Hex a, Hex b) { return Hex{ a.q - b.q, a.r - b.r }; }
+constexpr Hex operator*(Hex a, int k) { return Hex{ a.q * k, a.r * k }; }
+
+// The six neighbors, in the order of the edges of the tile models and of Tile::links
+constexpr Hex hex_directions[6] = { {1, 0}, {0, 1}, {-1, 1}, {-1, 0}, {0, -1}, {1, -1} };
+
+// Corners of a pointy hex of size 1 on the xz plane, corner i sits between edges i - 1 and i
+constexpr Vector2 hex_corners[6] = {
+    { 0.866025404f, -0.5f }, { 0.866025404f, 0.5f }, { 0.0f, 1.0f },
+    { -0.866025404f, 0.5f }, { -0.866025404f, -0.5f }, { 0.0f, -1.0f },
+};
+
+constexpr HexCube hex_to_cube(Hex h) { return HexCube{ h.q, h.r, -h.q - h.r }; }
+constexpr Hex cube_to_hex(HexCube c) { return Hex{ c.q, c.r }; }
+
+constexpr Hex hex_neighbor(Hex h, int direction) { return h + hex_directions[direction]; }
+
+constexpr int hex_abs(int v) { return (v < 0) ? -v : v; }
+
+constexpr int hex_length(Hex h)
+{
+    return (hex_abs(h.q) + hex_abs(h.r) + hex_abs(-h.q - h.r)) / 2;
+}
+
+constexpr int hex_distance(Hex a, Hex b) { return hex_length(a - b); }
+
+// Nearest hex to fractional axial coordinates, rounds in cube space so the result is always valid
+constexpr Hex hex_round(float q, float r)
+{
+    float s = -q - r;
+    auto round = [](float v) { int i = (int)v; float f = v - i; return (f >= 0.5f) ? i + 1 : (f < -0.5f) ? i - 1 : i; };
+    auto distance = [](float a, int b) { return (a > b) ? a - b : b - a; };
+    int rq = round(q);
+    int rr = round(r);
+    int rs = round(s);
+    float dq = distance(q, rq);
+    float dr = distance(r, rr);
+    float ds = distance(s, rs);
+    if (dq > dr && dq > ds) rq = -rr - rs;
+    else if (dr > ds) rr = -rq - rs;
+    return Hex{ rq, rr };
+}
+
+// Center of a pointy hex on the xz plane, size is the distance from the center to a corner
+constexpr Vector3 hex_to_world(Hex h, float size)
+{
+    return Vector3{ size * HEX_SQRT3 * h.q + size * HEX_SQRT3 / 2 * h.r, 0.0f, size * 1.5f * h.r };
+}
+
+// Hex that contains the point on the xz plane, the inverse of hex_to_world
+constexpr Hex hex_from_world(Vector3 position, float size)
+{
+    float q = (HEX_SQRT3 / 3 * position.x - 1.0f / 3 * position.z) / size;
+    float r = (2.0f / 3 * position.z) / size;
+    return hex_round(q, r);
+}
+
+// Center of a flat topped hex, for 2D layouts
+constexpr Vector2 hex_to_pixel_flat(Hex h, float size)
+{
+    return Vector2{ size * 1.5f * h.q, size * (HEX_SQRT3 / 2 * h.q + HEX_SQRT3 * h.r) };
+}
+
+// Number of hexes hex_ring and hex_spiral write
+constexpr int hex_ring_count(int radius) { return (radius == 0) ? 1 : 6 * radius; }
+constexpr int hex_spiral_count(int radius) { return 1 + 3 * radius * (radius + 1); }
+
+// Hexes at exactly radius steps from center, writes at most max and returns the full count
+constexpr int hex_ring(Hex center, int radius, Hex* out, int max)
+{
+    if (radius == 0) {
+        if (max > 0) out[0] = center;
+        return 1;
+    }
+
+    int count = 0;
+    Hex h = center + hex_directions[0] * radius;
+    for (int side = 0; side < 6; ++side) {
+        for (int step = 0; step < radius; ++step) {
+            if (count < max) out[count] = h;
+            ++count;
+            h = hex_neighbor(h, (side + 2) % 6);
+        }
+    }
+    return count;
+}
+
+// Center first followed by the rings out to radius
+constexpr int hex_spiral(Hex center, int radius, Hex* out, int max)
+{
+    int count = 0;
+    for (int ring = 0; ring <= radius; ++ring) {
+        count += hex_ring(center, ring, out + count, (max > count) ? max - count : 0);
+    }
+    return count;
+}
+
+// Hexes on the straight line from a to b including both ends, there are hex_distance(a, b) + 1
+constexpr int hex_line(Hex a, Hex b, Hex* out, int max)
+{
+    int steps = hex_distance(a, b);
+    for (int i = 0; i <= steps && i < max; ++i) {
+        // The nudge keeps points exactly on an edge from flipping between the two sides
+        float t = (steps == 0) ? 0.0f : (float)i / steps;
+        float q = a.q + (b.q - a.q) * t + 1e-6f;
+        float r = a.r + (b.r - a.r) * t + 2e-6f;
+        out[i] = hex_round(q, r);
+    }
+    return steps + 1;
+}
+
+inline void hex_to_world_batch(const Hex* hexes, int count, float size, Vector3 origin, Vector3* out)
+{
+    int i = 0;
+#if defined(HEX_SSE2)
+    const __m128 kq = _mm_set1_ps(size * HEX_SQRT3);
+    const __m128 kr = _mm_set1_ps(size * HEX_SQRT3 / 2);
+    const __m128 kz = _mm_set1_ps(size * 1.5f);
+    const __m128 ox = _mm_set1_ps(origin.x);
+    const __m128 oz = _mm_set1_ps(origin.z);
+    for (; i + 4 <= count; i += 4) {
+        // q0 r0 q1 r1 and q2 r2 q3 r3, split into q0..q3 and r0..r3
+        __m128 a = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&hexes[i]));
+        __m128 b = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&hexes[i + 2]));
+        __m128 q = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+        float x[4];
+        float z[4];
+        _mm_storeu_ps(x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(kq, q), _mm_mul_ps(kr, r)), ox));
+        _mm_storeu_ps(z, _mm_add_ps(_mm_mul_ps(kz, r), oz));
+        for (int j = 0; j < 4; ++j) out[i + j] = Vector3{ x[j], origin.y, z[j] };
+    }
+#endif
+    for (; i < count; ++i) {
+        Vector3 p = hex_to_world(hexes[i], size);
+        out[i] = Vector3{ p.x + origin.x, origin.y, p.z + origin.z };
+    }
+}
+
+// Model matrices that scale uniformly and move to the hex centers, as MatrixScale * MatrixTranslate
+inline void hex_transforms_batch(const Hex* hexes, int count, float size, Vector3 origin, float scale, Matrix* out)
+{
+    Vector3 positions[64];
+    for (int start = 0; start < count; start += 64) {
+        int n = (count - start < 64) ? count - start : 64;
+        hex_to_world_batch(hexes + start, n, size, origin, positions);
+        for (int i = 0; i < n; ++i) {
+            out[start + i] = Matrix{
+                scale, 0.0f, 0.0f, positions[i].x,
+                0.0f, scale, 0.0f, positions[i].y,
+                0.0f, 0.0f, scale, positions[i].z,
+                0.0f, 0.0f, 0.0f, 1.0f };
+        }
+    }
+}
+
+static_assert(hex_distance(Hex{ 0, 0 }, Hex{ 3, -1 }) == 3);
+static_assert(hex_round(0.6f, -0.2f) == Hex{ 1, 0 });
+static_assert(hex_from_world(hex_to_world(Hex{ -4, 7 }, 0.5f), 0.5f) == Hex{ -4, 7 });
+static_assert(hex_spiral_count(2) == 19);
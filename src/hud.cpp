@@ -0,0 +1,53 @@
+#include "hud.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+bool hud_text_stale(HudText* text, unsigned int key)
+{
+    if (text->valid && text->key == key) return false;
+
+    text->valid = true;
+    text->key = key;
+    text->length = 0;
+    text->text[0] = '\0';
+    return true;
+}
+
+void hud_text_format(HudText* text, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(text->text, HUD_TEXT_MAX, format, args);
+    va_end(args);
+
+    if (written < 0) written = 0;
+    text->length = (written < HUD_TEXT_MAX) ? written : HUD_TEXT_MAX - 1;
+    text->text[text->length] = '\0';
+}
+
+void hud_text_invalidate(HudText* text)
+{
+    text->valid = false;
+}
+
+Rectangle hud_panel_layout(HudPanel* panel, Vector3 anchor, Camera3D camera, float width, float height)
+{
+    if (panel->valid && memcmp(&panel->anchor, &anchor, sizeof(Vector3)) == 0 &&
+        memcmp(&panel->camera, &camera, sizeof(Camera3D)) == 0 &&
+        panel->screen_width == GetScreenWidth() && panel->screen_height == GetScreenHeight() &&
+        panel->bounds.width == width && panel->bounds.height == height) {
+        return panel->bounds;
+    }
+
+    Vector2 pos2D = GetWorldToScreen(anchor, camera);
+    panel->valid = true;
+    panel->anchor = anchor;
+    panel->camera = camera;
+    panel->screen_width = GetScreenWidth();
+    panel->screen_height = GetScreenHeight();
+    panel->bounds = Rectangle{ .x = pos2D.x - width / 2, .y = pos2D.y - height * 1.3f,
+                               .width = width, .height = height };
+    return panel->bounds;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+Retained HUD state. Texts remember the key of the values they were formatted from and are only
+formatted again when the key changes, keys are built from the values at display precision so a
+supply going from 10.2 to 10.3 doesn't rebuild a label that shows 10. Panels that float above a
+point in the world only lay themselves out again when that point, the camera or the window changed.
+
+Drawing still goes through raygui every frame, but it only ever draws cached text.
+*/
+
+#include "raylib.h"
+
+#define HUD_TEXT_MAX 256
+
+struct HudText {
+    bool valid;
+    unsigned int key;
+    int length;
+    char text[HUD_TEXT_MAX];
+};
+
+struct HudPanel {
+    bool valid;
+    Vector3 anchor;
+    Camera3D camera;
+    int screen_width;
+    int screen_height;
+    Rectangle bounds;
+};
+
+// Mixes value into a key
+constexpr unsigned int hud_key(unsigned int key, int value)
+{
+    return (key ^ (unsigned int)value) * 16777619u;
+}
+
+// Returns true if text was built from a different key, the text is then cleared and has to be formatted again
+bool hud_text_stale(HudText* text, unsigned int key);
+
+// Replaces the text
+void hud_text_format(HudText* text, const char* format, ...);
+
+void hud_text_invalidate(HudText* text);
+
+// Screen rectangle of a width x height panel centered above anchor
+Rectangle hud_panel_layout(HudPanel* panel, Vector3 anchor, Camera3D camera, float width, float height);
@@ -0,0 +1,202 @@
+#include "memory.hpp"
+
+#include "raylib.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+
+#if defined(ECONOMIA_RAYLIB_HOOKS)
+extern "C" void raylib_hook_install(void* (*malloc_hook)(size_t), void* (*calloc_hook)(size_t, size_t),
+    void* (*realloc_hook)(void*, size_t), void (*free_hook)(void*));
+#endif
+
+#define MEMORY_MAGIC 0x4d454d54u    // "MEMT", catches pointers that didn't come from here
+
+// In front of every allocation, 16 bytes keep the alignment malloc gives
+struct MemoryHeader {
+    uint64_t bytes;
+    uint32_t tag;
+    uint32_t magic;
+};
+
+static_assert(sizeof(MemoryHeader) == 16);
+
+struct MemoryCounters {
+    std::atomic<int64_t> live_bytes;
+    std::atomic<int64_t> peak_bytes;
+    std::atomic<int64_t> live_count;
+    std::atomic<int64_t> total_count;
+};
+
+static const char* _tag_names[MEMORY_TAG_COUNT] = { "world", "assets", "render", "raylib" };
+
+static MemoryCounters _counters[MEMORY_TAG_COUNT];
+static thread_local MemoryTag _scope = MEMORY_TAG_RAYLIB;
+
+// Only touched by memory_sample on the main thread
+static double _sample_time = 0.0;
+static int64_t _sample_totals[MEMORY_TAG_COUNT] = { 0 };
+static float _rates[MEMORY_TAG_COUNT] = { 0 };
+
+static void memory_count(MemoryTag tag, int64_t bytes, int64_t count)
+{
+    MemoryCounters* c = &_counters[tag];
+    int64_t live = c->live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    c->live_count.fetch_add(count, std::memory_order_relaxed);
+    if (count > 0) c->total_count.fetch_add(count, std::memory_order_relaxed);
+
+    int64_t peak = c->peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !c->peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+static MemoryHeader* memory_header(void* ptr)
+{
+    MemoryHeader* header = (MemoryHeader*)ptr - 1;
+    if (header->magic != MEMORY_MAGIC || header->tag >= MEMORY_TAG_COUNT) {
+        TraceLog(LOG_ERROR, "MEMORY: %p wasn't allocated by the tracker", ptr);
+        return nullptr;
+    }
+    return header;
+}
+
+static void* memory_track(MemoryHeader* header, MemoryTag tag, size_t bytes)
+{
+    if (header == nullptr) return nullptr;
+    *header = MemoryHeader{ bytes, (uint32_t)tag, MEMORY_MAGIC };
+    memory_count(tag, (int64_t)bytes, 1);
+    return header + 1;
+}
+
+void* memory_alloc(MemoryTag tag, size_t bytes)
+{
+    return memory_track((MemoryHeader*)malloc(sizeof(MemoryHeader) + bytes), tag, bytes);
+}
+
+void* memory_calloc(MemoryTag tag, size_t count, size_t size)
+{
+    if (size != 0 && count > (SIZE_MAX - sizeof(MemoryHeader)) / size) return nullptr;
+    return memory_track((MemoryHeader*)calloc(1, sizeof(MemoryHeader) + count * size), tag, count * size);
+}
+
+void* memory_realloc(MemoryTag tag, void* ptr, size_t bytes)
+{
+    if (ptr == nullptr) return memory_alloc(tag, bytes);
+
+    MemoryHeader* header = memory_header(ptr);
+    if (header == nullptr) return nullptr;
+    MemoryHeader old = *header;
+    MemoryHeader* moved = (MemoryHeader*)realloc(header, sizeof(MemoryHeader) + bytes);
+    if (moved == nullptr) return nullptr;
+
+    memory_count((MemoryTag)old.tag, -(int64_t)old.bytes, -1);
+    return memory_track(moved, (MemoryTag)old.tag, bytes);
+}
+
+void memory_free(void* ptr)
+{
+    if (ptr == nullptr) return;
+    MemoryHeader* header = memory_header(ptr);
+    if (header == nullptr) return;
+    memory_count((MemoryTag)header->tag, -(int64_t)header->bytes, -1);
+    header->magic = 0;
+    free(header);
+}
+
+const char* memory_tag_name(MemoryTag tag)
+{
+    return (tag >= 0 && tag < MEMORY_TAG_COUNT) ? _tag_names[tag] : "unknown";
+}
+
+MemoryStats memory_stats(MemoryTag tag)
+{
+    const MemoryCounters* c = &_counters[tag];
+    return MemoryStats{
+        c->live_bytes.load(std::memory_order_relaxed),
+        c->peak_bytes.load(std::memory_order_relaxed),
+        c->live_count.load(std::memory_order_relaxed),
+        c->total_count.load(std::memory_order_relaxed),
+        _rates[tag] };
+}
+
+MemoryTag memory_scope()
+{
+    return _scope;
+}
+
+MemoryTag memory_set_scope(MemoryTag tag)
+{
+    MemoryTag previous = _scope;
+    _scope = tag;
+    return previous;
+}
+
+#if defined(ECONOMIA_RAYLIB_HOOKS)
+static void* memory_raylib_malloc(size_t bytes) { return memory_alloc(_scope, bytes); }
+static void* memory_raylib_calloc(size_t count, size_t size) { return memory_calloc(_scope, count, size); }
+static void* memory_raylib_realloc(void* ptr, size_t bytes) { return memory_realloc(_scope, ptr, bytes); }
+#endif
+
+void memory_hook_raylib()
+{
+#if defined(ECONOMIA_RAYLIB_HOOKS)
+    raylib_hook_install(memory_raylib_malloc, memory_raylib_calloc, memory_raylib_realloc, memory_free);
+#endif
+}
+
+void memory_sample(double now)
+{
+    if (now - _sample_time < MEMORY_SAMPLE_INTERVAL) return;
+    for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        int64_t total = _counters[i].total_count.load(std::memory_order_relaxed);
+        _rates[i] = (_sample_time > 0.0) ? (float)((total - _sample_totals[i]) / (now - _sample_time)) : 0.0f;
+        _sample_totals[i] = total;
+    }
+    _sample_time = now;
+}
+
+void memory_draw_overlay(int x, int y)
+{
+    const int width = 330;
+    const int height = 24 + (MEMORY_TAG_COUNT + 1) * 12 + 6;
+    DrawRectangle(x, y, width, height, Fade(BLACK, 0.75f));
+    DrawText("Memory", x + 6, y + 6, 10, WHITE);
+    DrawText("live MB", x + 70, y + 6, 10, LIGHTGRAY);
+    DrawText("peak MB", x + 140, y + 6, 10, LIGHTGRAY);
+    DrawText("allocs", x + 210, y + 6, 10, LIGHTGRAY);
+    DrawText("per sec", x + 270, y + 6, 10, LIGHTGRAY);
+
+    MemoryStats total = { 0 };
+    for (int i = 0; i <= MEMORY_TAG_COUNT; ++i) {
+        MemoryStats stats = total;
+        if (i < MEMORY_TAG_COUNT) {
+            stats = memory_stats((MemoryTag)i);
+            total.live_bytes += stats.live_bytes;
+            total.peak_bytes += stats.peak_bytes;
+            total.live_count += stats.live_count;
+            total.rate += stats.rate;
+        }
+
+        int row_y = y + 24 + i * 12;
+        DrawText((i < MEMORY_TAG_COUNT) ? _tag_names[i] : "total", x + 6, row_y, 10, WHITE);
+        DrawText(TextFormat("%7.2f", stats.live_bytes / (1024.0 * 1024.0)), x + 70, row_y, 10, WHITE);
+        DrawText(TextFormat("%7.2f", stats.peak_bytes / (1024.0 * 1024.0)), x + 140, row_y, 10, WHITE);
+        DrawText(TextFormat("%lld", (long long)stats.live_count), x + 210, row_y, 10, WHITE);
+        DrawText(TextFormat("%.0f", stats.rate), x + 270, row_y, 10, WHITE);
+    }
+}
+
+void memory_dump()
+{
+    for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        MemoryStats stats = memory_stats((MemoryTag)i);
+        TraceLog(LOG_INFO, "MEMORY: %-7s %10lld bytes live in %6lld allocations, peak %10lld, %lld allocations",
+            _tag_names[i], (long long)stats.live_bytes, (long long)stats.live_count, (long long)stats.peak_bytes,
+            (long long)stats.total_count);
+        if (stats.live_count > 0) {
+            TraceLog(LOG_WARNING, "MEMORY: %s leaks %lld bytes in %lld allocations", _tag_names[i],
+                (long long)stats.live_bytes, (long long)stats.live_count);
+        }
+    }
+}
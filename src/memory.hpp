@@ -0,0 +1,73 @@
+#pragma once
+
+/*
+Allocation tracking by subsystem. Every allocation of the game goes through memory_alloc and friends
+with the tag of the subsystem it belongs to, the tracker keeps the live bytes, the peak, the number of
+live allocations and how many allocations are made per second for each tag. F5 shows them as an
+overlay and memory_dump logs them on exit, tags that still have live allocations then are leaks.
+
+raylib's own allocations (RL_MALLOC and friends, MemAlloc) are routed here too when raylib is built
+from source, see raylib/memory_hooks.c. They are tagged with the scope of the calling thread, which
+is MEMORY_TAG_RAYLIB unless a MEMORY_SCOPE says otherwise:
+
+    MEMORY_SCOPE(MEMORY_TAG_ASSETS);
+    Model model = LoadModel(path);      // Meshes and materials count as assets
+
+Memory that raylib frees, or that comes from raylib, has to be allocated and freed with MemAlloc and
+MemFree, never with memory_alloc or free. Everything else uses the functions below, memory_free works
+for any tag.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum MemoryTag {
+    MEMORY_TAG_WORLD,       // Tiles, people and everything else the simulation keeps
+    MEMORY_TAG_ASSETS,      // Models, file data and decoded images
+    MEMORY_TAG_RENDER,      // Draw queues, overlays and baked animations
+    MEMORY_TAG_RAYLIB,      // raylib internals outside of any scope
+    MEMORY_TAG_COUNT
+};
+
+struct MemoryStats {
+    int64_t live_bytes;
+    int64_t peak_bytes;
+    int64_t live_count;
+    int64_t total_count;    // Allocations since the start
+    float rate;             // Allocations per second over the last memory_sample interval
+};
+
+#define MEMORY_SAMPLE_INTERVAL 1.0  // Seconds between updates of the allocation rate
+
+void* memory_alloc(MemoryTag tag, size_t bytes);
+void* memory_calloc(MemoryTag tag, size_t count, size_t size);
+// Keeps the tag of ptr if there is one
+void* memory_realloc(MemoryTag tag, void* ptr, size_t bytes);
+void memory_free(void* ptr);
+
+const char* memory_tag_name(MemoryTag tag);
+MemoryStats memory_stats(MemoryTag tag);
+
+// Installs the raylib hooks, call before anything else touches raylib
+void memory_hook_raylib();
+
+// Call once per frame, updates the allocation rates
+void memory_sample(double now);
+void memory_draw_overlay(int x, int y);
+// Logs the stats of every tag and warns about the ones with live allocations
+void memory_dump();
+
+// Tag of the raylib allocations made on this thread
+MemoryTag memory_scope();
+MemoryTag memory_set_scope(MemoryTag tag);
+
+struct MemoryScope {
+    MemoryTag previous;
+
+    MemoryScope(MemoryTag tag) : previous(memory_set_scope(tag)) {}
+    ~MemoryScope() { memory_set_scope(previous); }
+};
+
+#define MEMORY_CONCAT_(a, b) a##b
+#define MEMORY_CONCAT(a, b) MEMORY_CONCAT_(a, b)
+#define MEMORY_SCOPE(tag) MemoryScope MEMORY_CONCAT(_memory_scope_, __LINE__)(tag)
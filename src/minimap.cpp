@@ -0,0 +1,157 @@
+#include "minimap.hpp"
+#include "memory.hpp"
+#include "world.hpp"
+
+#include <stdlib.h>
+
+static Color* _pixels = nullptr;
+static Color* _upload = nullptr;        // Scratch for the dirty rectangle
+static int _width = 0;
+static int _height = 0;
+static Texture2D _texture = { 0 };
+
+static const Color _tile_colors[ECONOMY_TILE_COUNT] = {
+    Color{ 120, 180, 80, 255 },     // Grass
+    Color{ 220, 190, 90, 255 },     // Farm
+    Color{ 180, 90, 70, 255 },      // House
+    Color{ 50, 110, 50, 255 },      // Forest
+    Color{ 200, 170, 130, 255 },    // Road
+    Color{ 70, 130, 200, 255 },     // River
+};
+
+static const Color _empty_color = { 40, 40, 40, 255 };
+
+static int minimap_x(int q, int r)
+{
+    return q + r / 2;
+}
+
+// Tiles with goods in store are drawn brighter
+static Color minimap_color(const World* world, const Tile* t)
+{
+    if (t->type < 0 || t->type >= ECONOMY_TILE_COUNT) return _empty_color;
+
+    Color color = _tile_colors[t->type];
+    int level = 0;
+    for (int i = t->stock; i < t->stock + (int)t->stock_count; ++i) {
+        if (world->stocks[i].level > level) level = world->stocks[i].level;
+    }
+    float f = 0.4f * level / SUPPLY_LEVELS;
+    color.r = (unsigned char)(color.r + (255 - color.r) * f);
+    color.g = (unsigned char)(color.g + (255 - color.g) * f);
+    color.b = (unsigned char)(color.b + (255 - color.b) * f);
+    return color;
+}
+
+void minimap_init(const World* world)
+{
+    minimap_unload();
+
+    _width = world->max_q + (world->max_r - 1) / 2;
+    _height = world->max_r;
+    _pixels = (Color*)memory_calloc(MEMORY_TAG_RENDER, _width * _height, sizeof(Color));
+    _upload = (Color*)memory_calloc(MEMORY_TAG_RENDER, _width * _height, sizeof(Color));
+    if (_pixels == nullptr || _upload == nullptr) {
+        TraceLog(LOG_WARNING, "MINIMAP: Can't allocate %dx%d", _width, _height);
+        minimap_unload();
+        return;
+    }
+
+    // Texels outside of the board stay transparent
+    for (int q = 0; q < world->max_q; ++q) {
+        for (int r = 0; r < world->max_r; ++r) {
+            _pixels[r * _width + minimap_x(q, r)] = minimap_color(world, &world->tiles[q * world->max_r + r]);
+        }
+    }
+
+    Image image = { 0 };
+    image.data = _pixels;
+    image.width = _width;
+    image.height = _height;
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    _texture = LoadTextureFromImage(image);
+}
+
+void minimap_unload()
+{
+    if (_texture.id != 0) UnloadTexture(_texture);
+    _texture = Texture2D{ 0 };
+    memory_free(_pixels);
+    memory_free(_upload);
+    _pixels = nullptr;
+    _upload = nullptr;
+    _width = 0;
+    _height = 0;
+}
+
+int minimap_update(const World* world)
+{
+    if (_pixels == nullptr || world->change_count == 0) return 0;
+
+    int min_x = _width, min_y = _height, max_x = -1, max_y = -1;
+    int count = 0;
+    for (int i = 0; i < world->change_count; ++i) {
+        int index = world->changes[i];
+        int q = index / world->max_r;
+        int r = index % world->max_r;
+        int x = minimap_x(q, r);
+        Color color = minimap_color(world, &world->tiles[index]);
+        Color* texel = &_pixels[r * _width + x];
+        if (texel->r == color.r && texel->g == color.g && texel->b == color.b && texel->a == color.a) continue;
+
+        *texel = color;
+        ++count;
+        if (x < min_x) min_x = x;
+        if (x > max_x) max_x = x;
+        if (r < min_y) min_y = r;
+        if (r > max_y) max_y = r;
+    }
+    if (count == 0) return 0;
+
+    int w = max_x - min_x + 1;
+    int h = max_y - min_y + 1;
+    if (w * h <= count * MINIMAP_RECT_SLACK) {
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                _upload[y * w + x] = _pixels[(min_y + y) * _width + min_x + x];
+            }
+        }
+        UpdateTextureRec(_texture, Rectangle{ (float)min_x, (float)min_y, (float)w, (float)h }, _upload);
+    }
+    else {
+        for (int i = 0; i < world->change_count; ++i) {
+            int index = world->changes[i];
+            int r = index % world->max_r;
+            int x = minimap_x(index / world->max_r, r);
+            UpdateTextureRec(_texture, Rectangle{ (float)x, (float)r, 1, 1 }, &_pixels[r * _width + x]);
+        }
+    }
+    return count;
+}
+
+Vector2 minimap_size()
+{
+    return Vector2{ (float)_width, (float)_height };
+}
+
+void minimap_draw(Rectangle bounds)
+{
+    if (_texture.id == 0) return;
+    DrawTexturePro(_texture, Rectangle{ 0, 0, (float)_width, (float)_height }, bounds, Vector2{ 0, 0 }, 0.0f, WHITE);
+    DrawRectangleLinesEx(bounds, 1.0f, DARKGRAY);
+}
+
+bool minimap_pick(Rectangle bounds, Vector2 point, int* q, int* r)
+{
+    if (_texture.id == 0 || !CheckCollisionPointRec(point, bounds)) return false;
+
+    int x = (int)((point.x - bounds.x) / bounds.width * _width);
+    int y = (int)((point.y - bounds.y) / bounds.height * _height);
+    int tile_q = x - y / 2;
+    if (tile_q < 0 || tile_q >= _width - (_height - 1) / 2 || y < 0 || y >= _height) return false;
+
+    *q = tile_q;
+    *r = y;
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+Minimap, keeps an image with one texel per hex on the cpu and a texture with the same content. Only the
+tiles that the world reports as changed are recolored and uploaded, the per frame cost depends on the
+number of changes and not on the size of the board.
+
+Rows are shifted by half a hex like the board, so the image is wider than the board by max_r/2 texels.
+*/
+
+#include "raylib.h"
+
+struct World;
+
+// If the dirty texels are spread out more than this, they are uploaded one by one instead of as one rectangle
+#define MINIMAP_RECT_SLACK 4
+
+void minimap_init(const World* world);
+void minimap_unload();
+
+// Recolors the tiles in world->changes and uploads them, returns the number of texels that changed
+int minimap_update(const World* world);
+
+// Size of the minimap image in texels
+Vector2 minimap_size();
+
+void minimap_draw(Rectangle bounds);
+
+// Hex under point when the minimap is drawn into bounds, returns false outside of the board
+bool minimap_pick(Rectangle bounds, Vector2 point, int* q, int* r);
@@ -0,0 +1,267 @@
+#include "model_manager.hpp"
+#include "memory.hpp"
+
+#include "assets.hpp"
+#include "raylib.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum ModelSlotState {
+    MODEL_SLOT_UNLOADED = 0,
+    MODEL_SLOT_LOADING,
+    MODEL_SLOT_RESIDENT,
+    MODEL_SLOT_FAILED
+};
+
+struct ModelSlot {
+    char name[LOADER_PATH_LENGTH];
+    int state;
+    unsigned int last_used;
+    size_t bytes;
+    Model model;
+    ModelLoad* load;
+};
+
+static ModelSlot _slots[MODEL_MANAGER_MAX] = { 0 };
+static int _slot_count = 0;
+
+static Model _placeholder = { 0 };
+static unsigned int _frame = 1;
+static size_t _budget = MODEL_BUDGET_DEFAULT;
+static size_t _resident_bytes = 0;
+static int _evictions = 0;
+static bool _over_budget_logged = false;
+
+void model_manager_init(size_t budget_bytes)
+{
+    _budget = budget_bytes;
+    loader_start(0);
+
+    // Flat hexagon, shown while the real model is streaming in
+    _placeholder = LoadModelFromMesh(GenMeshCylinder(0.5f, 0.05f, 6));
+    _placeholder.materials[0].maps[MATERIAL_MAP_DIFFUSE].color = LIGHTGRAY;
+}
+
+static void model_manager_evict(ModelSlot* slot)
+{
+    model_unload(&slot->model);
+    slot->model = Model{ 0 };
+    _resident_bytes -= slot->bytes;
+    slot->bytes = 0;
+    slot->state = MODEL_SLOT_UNLOADED;
+}
+
+void model_manager_shutdown()
+{
+    for (int i = 0; i < _slot_count; ++i) {
+        ModelSlot* slot = &_slots[i];
+        if (slot->load != nullptr) {
+            model_load_cancel(slot->load);
+            memory_free(slot->load);
+            slot->load = nullptr;
+        }
+        if (slot->state == MODEL_SLOT_RESIDENT) model_manager_evict(slot);
+        slot->state = MODEL_SLOT_UNLOADED;
+    }
+    _slot_count = 0;
+
+    UnloadModel(_placeholder);
+    _placeholder = Model{ 0 };
+    loader_stop();
+}
+
+void model_manager_set_budget(size_t budget_bytes)
+{
+    _budget = budget_bytes;
+    _over_budget_logged = false;
+}
+
+ModelHandle model_manager_find(const char* name)
+{
+    for (int i = 0; i < _slot_count; ++i) {
+        if (strcmp(_slots[i].name, name) == 0) return i;
+    }
+    return MODEL_HANDLE_INVALID;
+}
+
+ModelHandle model_manager_register(const char* name)
+{
+    ModelHandle handle = model_manager_find(name);
+    if (handle != MODEL_HANDLE_INVALID) return handle;
+
+    if (_slot_count >= MODEL_MANAGER_MAX) {
+        TraceLog(LOG_WARNING, "MODELS: Too many models, can't register %s", name);
+        return MODEL_HANDLE_INVALID;
+    }
+
+    ModelSlot* slot = &_slots[_slot_count];
+    *slot = ModelSlot{ 0 };
+    strncpy(slot->name, name, LOADER_PATH_LENGTH - 1);
+    return _slot_count++;
+}
+
+int model_manager_register_list(const char* filename, const char* prefix)
+{
+    char* text = LoadFileText(filename);
+    if (text == nullptr) return 0;
+
+    int before = _slot_count;
+    char* line = text;
+    while (*line != '\0') {
+        char* end = line;
+        while (*end != '\0' && *end != '\n' && *end != '\r') ++end;
+        char next = *end;
+        *end = '\0';
+        if (end != line) model_manager_register(TextFormat("%s%s", prefix, line));
+        if (next == '\0') break;
+        line = end + 1;
+    }
+
+    UnloadFileText(text);
+    return _slot_count - before;
+}
+
+static void model_manager_request(ModelSlot* slot)
+{
+    if (slot->state != MODEL_SLOT_UNLOADED) return;
+
+    slot->load = (ModelLoad*)memory_calloc(MEMORY_TAG_ASSETS, 1, sizeof(ModelLoad));
+    if (slot->load == nullptr) return;
+    model_load_begin(slot->load, slot->name);
+    slot->state = MODEL_SLOT_LOADING;
+}
+
+const Model* model_manager_get(ModelHandle handle)
+{
+    if (handle < 0 || handle >= _slot_count) return &_placeholder;
+
+    ModelSlot* slot = &_slots[handle];
+    slot->last_used = _frame;
+    if (slot->state == MODEL_SLOT_RESIDENT) return &slot->model;
+
+    model_manager_request(slot);
+    return &_placeholder;
+}
+
+bool model_manager_is_ready(ModelHandle handle)
+{
+    if (handle < 0 || handle >= _slot_count) return false;
+    return _slots[handle].state == MODEL_SLOT_RESIDENT;
+}
+
+bool model_manager_is_finished(ModelHandle handle)
+{
+    if (handle < 0 || handle >= _slot_count) return false;
+    int state = _slots[handle].state;
+    return state == MODEL_SLOT_RESIDENT || state == MODEL_SLOT_FAILED;
+}
+
+void model_manager_prefetch(ModelHandle handle)
+{
+    if (handle < 0 || handle >= _slot_count) return;
+
+    ModelSlot* slot = &_slots[handle];
+    if (slot->last_used < _frame) slot->last_used = _frame;
+    model_manager_request(slot);
+}
+
+// Drops the least recently used models until the resident set fits the budget again,
+// anything that was used in the previous frame is kept
+static void model_manager_trim()
+{
+    while (_resident_bytes > _budget) {
+        ModelSlot* oldest = nullptr;
+        for (int i = 0; i < _slot_count; ++i) {
+            ModelSlot* slot = &_slots[i];
+            if (slot->state != MODEL_SLOT_RESIDENT || slot->last_used + 1 >= _frame) continue;
+            if (oldest == nullptr || slot->last_used < oldest->last_used) oldest = slot;
+        }
+
+        if (oldest == nullptr) {
+            if (!_over_budget_logged) {
+                TraceLog(LOG_WARNING, "MODELS: Models in use (%zu bytes) exceed the budget of %zu bytes",
+                    _resident_bytes, _budget);
+                _over_budget_logged = true;
+            }
+            return;
+        }
+
+        TraceLog(LOG_DEBUG, "MODELS: Evicting %s", oldest->name);
+        model_manager_evict(oldest);
+        ++_evictions;
+    }
+    _over_budget_logged = false;
+}
+
+void model_manager_update(double budget)
+{
+    ++_frame;
+
+    double start = GetTime();
+    loader_pump(budget);
+
+    bool uploaded = false;
+    for (int i = 0; i < _slot_count; ++i) {
+        ModelSlot* slot = &_slots[i];
+        if (slot->state != MODEL_SLOT_LOADING) continue;
+
+        // Always allow one upload per frame so loading can't stall
+        bool upload = !uploaded || (GetTime() - start < budget);
+        int state = model_load_poll(slot->load, upload, &slot->model);
+
+        if (state == MODEL_LOAD_DONE) {
+            slot->bytes = model_memory_size(&slot->model);
+            _resident_bytes += slot->bytes;
+            slot->state = MODEL_SLOT_RESIDENT;
+            uploaded = true;
+        }
+        else if (state == MODEL_LOAD_FAILED) {
+            slot->state = MODEL_SLOT_FAILED;
+        }
+
+        if (state == MODEL_LOAD_DONE || state == MODEL_LOAD_FAILED) {
+            memory_free(slot->load);
+            slot->load = nullptr;
+        }
+    }
+
+    model_manager_trim();
+}
+
+float model_manager_progress()
+{
+    int finished = 0;
+    int loading = 0;
+    for (int i = 0; i < _slot_count; ++i) {
+        if (_slots[i].state == MODEL_SLOT_LOADING) ++loading;
+        else if (model_manager_is_finished(i)) ++finished;
+    }
+    if (loading == 0) return 1.0f;
+    return (float)finished/(float)(finished + loading);
+}
+
+ModelManagerStats model_manager_stats()
+{
+    ModelManagerStats stats = { 0 };
+    stats.registered = _slot_count;
+    for (int i = 0; i < _slot_count; ++i) {
+        if (_slots[i].state == MODEL_SLOT_RESIDENT) ++stats.resident;
+        else if (_slots[i].state == MODEL_SLOT_LOADING) ++stats.loading;
+    }
+    stats.evictions = _evictions;
+    stats.resident_bytes = _resident_bytes;
+    stats.budget_bytes = _budget;
+    return stats;
+}
+
+void model_manager_rebind_shader(Shader from, Shader to)
+{
+    for (int i = 0; i < _slot_count; ++i) {
+        ModelSlot* slot = &_slots[i];
+        if (slot->state != MODEL_SLOT_RESIDENT) continue;
+        for (int mat = 0; mat < slot->model.materialCount; ++mat) {
+            if (slot->model.materials[mat].shader.id == from.id) slot->model.materials[mat].shader = to;
+        }
+    }
+}
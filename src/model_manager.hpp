@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+Model manager, models are referred to by handles that stay valid for the lifetime of the manager.
+A model is streamed in the first time it is drawn or prefetched, until it is ready a placeholder is
+returned instead. Whenever the resident meshes go over the memory budget the models that weren't
+used in the last frame are evicted, least recently used first.
+*/
+
+#include <stddef.h>
+
+struct Model;
+struct Shader;
+
+typedef int ModelHandle;
+
+#define MODEL_HANDLE_INVALID -1
+#define MODEL_MANAGER_MAX 256
+#define MODEL_BUDGET_DEFAULT (32 * 1024 * 1024)
+
+struct ModelManagerStats {
+    int registered;
+    int resident;
+    int loading;
+    int evictions;
+    size_t resident_bytes;
+    size_t budget_bytes;
+};
+
+void model_manager_init(size_t budget_bytes);
+void model_manager_shutdown();
+
+void model_manager_set_budget(size_t budget_bytes);
+
+// Registering a name twice returns the same handle, names are relative to the resources directory
+ModelHandle model_manager_register(const char* name);
+
+// Registers every line of a text file as prefix + line, returns the number of new models
+int model_manager_register_list(const char* filename, const char* prefix);
+
+ModelHandle model_manager_find(const char* name);
+
+// Returns the model for drawing this frame, or the placeholder if it isn't loaded yet
+const Model* model_manager_get(ModelHandle handle);
+
+bool model_manager_is_ready(ModelHandle handle);
+// Ready or failed to load, either way nothing is pending. Failed models are drawn as the placeholder
+bool model_manager_is_finished(ModelHandle handle);
+
+// Starts loading a model that is going to be needed soon
+void model_manager_prefetch(ModelHandle handle);
+
+// Call once per frame, uploads loaded models until budget (in seconds) is used up and evicts
+void model_manager_update(double budget);
+
+// Fraction of the requested models that are finished, 1 when nothing is loading
+float model_manager_progress();
+
+ModelManagerStats model_manager_stats();
+
+// Switches the materials of all resident models that use shader from to shader to
+void model_manager_rebind_shader(Shader from, Shader to);
@@ -0,0 +1,117 @@
+#include "picking.hpp"
+#include "memory.hpp"
+#include "world.hpp"
+
+#include <stdlib.h>
+
+static float* _heights = nullptr;   // Top of every tile above the origin
+static float* _bounds = nullptr;    // Highest point of every chunk above the origin
+static int _chunks_q = 0;
+static int _chunks_r = 0;
+static int _max_q = 0;
+static int _max_r = 0;
+static Vector3 _origin = { 0 };
+static float _size = 1.0f;
+static float _ground = 0.0f;
+static float _top = 0.0f;           // Highest bound of all chunks
+
+void picking_init(const World* world, Vector3 origin, float size, float ground)
+{
+    picking_unload();
+
+    _max_q = world->max_q;
+    _max_r = world->max_r;
+    _chunks_q = (_max_q + PICKING_CHUNK - 1) / PICKING_CHUNK;
+    _chunks_r = (_max_r + PICKING_CHUNK - 1) / PICKING_CHUNK;
+    _origin = origin;
+    _size = size;
+    _ground = ground;
+    _top = ground;
+    _heights = (float*)memory_calloc(MEMORY_TAG_RENDER, _max_q * _max_r, sizeof(float));
+    _bounds = (float*)memory_calloc(MEMORY_TAG_RENDER, _chunks_q * _chunks_r, sizeof(float));
+    if (_heights == nullptr || _bounds == nullptr) {
+        TraceLog(LOG_WARNING, "PICKING: Can't allocate %dx%d tiles", _max_q, _max_r);
+        picking_unload();
+        return;
+    }
+    for (int i = 0; i < _max_q * _max_r; ++i) _heights[i] = ground;
+    for (int i = 0; i < _chunks_q * _chunks_r; ++i) _bounds[i] = ground;
+}
+
+void picking_unload()
+{
+    memory_free(_heights);
+    memory_free(_bounds);
+    _heights = nullptr;
+    _bounds = nullptr;
+    _chunks_q = 0;
+    _chunks_r = 0;
+    _max_q = 0;
+    _max_r = 0;
+}
+
+static bool picking_on_board(Hex hex)
+{
+    return hex.q >= 0 && hex.q < _max_q && hex.r >= 0 && hex.r < _max_r;
+}
+
+static float* picking_chunk(Hex hex)
+{
+    return &_bounds[(hex.q / PICKING_CHUNK) * _chunks_r + hex.r / PICKING_CHUNK];
+}
+
+void picking_set_height(Hex hex, float height)
+{
+    if (_heights == nullptr || !picking_on_board(hex)) return;
+
+    _heights[hex.q * _max_r + hex.r] = height;
+    float* bound = picking_chunk(hex);
+    if (height > *bound) *bound = height;
+    if (height > _top) _top = height;
+}
+
+// Hex under the point where the ray crosses the plane at height, t is the distance along the ray
+static Hex picking_at_height(Ray ray, float height, float* t)
+{
+    *t = (_origin.y + height - ray.position.y) / ray.direction.y;
+    Vector3 point = {
+        ray.position.x + ray.direction.x * *t - _origin.x,
+        0.0f,
+        ray.position.z + ray.direction.z * *t - _origin.z };
+    return hex_from_world(point, _size);
+}
+
+bool picking_pick(Ray ray, Hex* hex)
+{
+    if (_heights == nullptr || ray.direction.y >= 0.0f) return false;
+
+    float ground_t = 0.0f;
+    Hex ground = picking_at_height(ray, _ground, &ground_t);
+    if (ground_t < 0.0f) return false;
+
+    // Only walk the ray when something sticks out of the ground plane
+    if (_top > _ground) {
+        float top_t = 0.0f;
+        Hex top = picking_at_height(ray, _top, &top_t);
+        if (top_t < 0.0f) top_t = 0.0f;
+
+        Hex line[PICKING_LINE_MAX];
+        int count = hex_line(top, ground, line, PICKING_LINE_MAX);
+        if (count > PICKING_LINE_MAX) count = PICKING_LINE_MAX;
+        for (int i = 0; i < count; ++i) {
+            if (!picking_on_board(line[i])) continue;
+            float t = (count > 1) ? top_t + (ground_t - top_t) * i / (count - 1) : ground_t;
+            float y = ray.position.y + ray.direction.y * t - _origin.y;
+            // Chunks that are lower than the ray can't have a hit, only the others look at their tiles
+            if (y > *picking_chunk(line[i])) continue;
+            if (y <= _heights[line[i].q * _max_r + line[i].r]) {
+                *hex = line[i];
+                return true;
+            }
+        }
+    }
+
+    if (!picking_on_board(ground)) return false;
+    *hex = ground;
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+Mouse picking on the board without testing any meshes. The ray is intersected with the plane of the
+tile tops and the hit point is turned back into a hex with hex_from_world, that is the same cost on any
+board size.
+
+Tall things are handled with a height per tile and a bound per chunk of PICKING_CHUNK x PICKING_CHUNK
+tiles. When something sticks out of the ground plane the ray is walked over the few hexes between the
+top bound and the ground, the first hex that is taller than the ray at that point wins. Hexes in chunks
+that are lower than the ray are skipped without looking at their tiles.
+*/
+
+#include "raylib.h"
+#include "hex.hpp"
+
+struct World;
+
+#define PICKING_CHUNK 16
+#define PICKING_LINE_MAX 64     // Longest walk between the top bound and the ground, in hexes
+
+// The board is laid out like hex_to_world(hex, size) + origin, ground is the height of the tile tops
+void picking_init(const World* world, Vector3 origin, float size, float ground);
+void picking_unload();
+
+// Sets the top of the tile, the bound of its chunk never shrinks until the next init
+void picking_set_height(Hex hex, float height);
+
+// Hex under the ray, returns false if the ray misses the board
+bool picking_pick(Ray ray, Hex* hex);
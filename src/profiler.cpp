@@ -0,0 +1,222 @@
+#include "profiler.hpp"
+
+#if defined(ECONOMIA_PROFILE)
+
+#include "raylib.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+// The dump skips the oldest zones of other threads, they may be overwritten while it reads them
+#define PROFILE_DUMP_MARGIN 256
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    int depth;
+};
+
+struct ProfileThread {
+    char name[32];
+    int id;
+    int depth;
+    std::atomic<uint64_t> head;     // Number of zones ever written, only the owner writes
+    ProfileEvent events[PROFILE_RING_SIZE];
+};
+
+// Threads are registered on their first zone and stay around until exit
+static ProfileThread* _threads[PROFILE_THREADS_MAX] = { 0 };
+static std::atomic<int> _thread_count = 0;
+static std::mutex _threads_mutex;
+static thread_local ProfileThread* _thread = nullptr;
+
+static ProfileThread* _main_thread = nullptr;
+static uint64_t _frame_start = 0;
+static uint64_t _last_frame_start = 0;
+static uint64_t _last_frame_end = 0;
+
+uint64_t profile_now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static ProfileThread* profile_thread()
+{
+    if (_thread != nullptr) return _thread;
+
+    std::lock_guard<std::mutex> lock(_threads_mutex);
+    int count = _thread_count.load();
+    if (count >= PROFILE_THREADS_MAX) return nullptr;
+
+    ProfileThread* thread = new ProfileThread();
+    thread->id = count;
+    snprintf(thread->name, sizeof(thread->name), "thread %d", count);
+    _threads[count] = thread;
+    _thread_count.store(count + 1, std::memory_order_release);
+    _thread = thread;
+    return thread;
+}
+
+void profile_zone_begin()
+{
+    ProfileThread* thread = profile_thread();
+    if (thread != nullptr) ++thread->depth;
+}
+
+void profile_zone_end(const char* name, uint64_t start)
+{
+    ProfileThread* thread = _thread;
+    if (thread == nullptr) return;
+
+    --thread->depth;
+    uint64_t head = thread->head.load(std::memory_order_relaxed);
+    thread->events[head % PROFILE_RING_SIZE] = ProfileEvent{ name, start, profile_now(), thread->depth };
+    thread->head.store(head + 1, std::memory_order_release);
+}
+
+void profile_thread_name(const char* name)
+{
+    ProfileThread* thread = profile_thread();
+    if (thread != nullptr) snprintf(thread->name, sizeof(thread->name), "%s", name);
+}
+
+void profile_frame_mark()
+{
+    if (_main_thread == nullptr) {
+        _main_thread = profile_thread();
+        profile_thread_name("main");
+    }
+
+    uint64_t now = profile_now();
+    _last_frame_start = _frame_start;
+    _last_frame_end = now;
+    _frame_start = now;
+}
+
+struct ProfileZoneTotal {
+    const char* name;
+    uint64_t total;
+    int calls;
+};
+
+static Color profile_color(const char* name)
+{
+    unsigned int hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; ++c) hash = (hash ^ (unsigned char)*c) * 16777619u;
+    return Color{ (unsigned char)(80 + hash % 150), (unsigned char)(80 + (hash >> 8) % 150),
+                  (unsigned char)(80 + (hash >> 16) % 150), 255 };
+}
+
+void profile_draw_overlay(int x, int y)
+{
+    const ProfileThread* thread = _main_thread;
+    if (thread == nullptr || _last_frame_start == 0) return;
+
+    const int width = 420;
+    const int rows = 12;
+    const int flame_depth = 6;
+    const int height = 24 + rows * 12 + 8 + flame_depth * 14 + 8;
+    DrawRectangle(x, y, width, height, Fade(BLACK, 0.75f));
+
+    uint64_t frame = _last_frame_end - _last_frame_start;
+    DrawText(TextFormat("Frame %.2f ms", frame / 1.0e6), x + 6, y + 6, 10, WHITE);
+
+    // Zones of the last complete frame, the ring is ordered by end time
+    ProfileZoneTotal zones[PROFILE_ZONES_MAX] = { 0 };
+    int zone_count = 0;
+    int flame_y = y + 24 + rows * 12 + 8;
+    uint64_t head = thread->head.load(std::memory_order_acquire);
+    uint64_t oldest = (head > PROFILE_RING_SIZE) ? head - PROFILE_RING_SIZE : 0;
+    for (uint64_t i = head; i > oldest; --i) {
+        const ProfileEvent* e = &thread->events[(i - 1) % PROFILE_RING_SIZE];
+        if (e->end <= _last_frame_start) break;
+        if (e->start < _last_frame_start || e->end > _last_frame_end) continue;
+
+        int z = 0;
+        while (z < zone_count && zones[z].name != e->name && strcmp(zones[z].name, e->name) != 0) ++z;
+        if (z == zone_count && zone_count < PROFILE_ZONES_MAX) zones[zone_count++] = ProfileZoneTotal{ e->name, 0, 0 };
+        if (z < zone_count) {
+            zones[z].total += e->end - e->start;
+            ++zones[z].calls;
+        }
+
+        if (e->depth >= flame_depth) continue;
+        int x0 = x + 6 + (int)((e->start - _last_frame_start) * (width - 12) / frame);
+        int x1 = x + 6 + (int)((e->end - _last_frame_start) * (width - 12) / frame);
+        int w = (x1 - x0 > 1) ? x1 - x0 : 1;
+        int bar_y = flame_y + e->depth * 14;
+        DrawRectangle(x0, bar_y, w, 12, profile_color(e->name));
+        if (MeasureText(e->name, 10) + 4 < w) DrawText(e->name, x0 + 2, bar_y + 1, 10, BLACK);
+    }
+
+    // Most expensive zones first
+    for (int i = 0; i < rows && i < zone_count; ++i) {
+        int best = i;
+        for (int j = i + 1; j < zone_count; ++j) {
+            if (zones[j].total > zones[best].total) best = j;
+        }
+        ProfileZoneTotal swap = zones[i];
+        zones[i] = zones[best];
+        zones[best] = swap;
+
+        int row_y = y + 24 + i * 12;
+        DrawText(zones[i].name, x + 6, row_y, 10, profile_color(zones[i].name));
+        DrawText(TextFormat("%7.3f ms", zones[i].total / 1.0e6), x + 240, row_y, 10, WHITE);
+        DrawText(TextFormat("%d", zones[i].calls), x + 330, row_y, 10, LIGHTGRAY);
+    }
+}
+
+static void profile_write_string(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const char* c = text; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') fputc('\\', file);
+        if ((unsigned char)*c >= ' ') fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool profile_dump_chrome(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (file == nullptr) {
+        TraceLog(LOG_WARNING, "PROFILE: Can't write %s", filename);
+        return false;
+    }
+
+    fputs("{\"traceEvents\":[\n", file);
+    bool first = true;
+    int events = 0;
+    int thread_count = _thread_count.load(std::memory_order_acquire);
+    for (int t = 0; t < thread_count; ++t) {
+        const ProfileThread* thread = _threads[t];
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", thread->id);
+        profile_write_string(file, thread->name);
+        fputs("}}", file);
+        first = false;
+
+        uint64_t head = thread->head.load(std::memory_order_acquire);
+        uint64_t oldest = (head > PROFILE_RING_SIZE) ? head - PROFILE_RING_SIZE : 0;
+        if (thread != _thread && head > PROFILE_RING_SIZE) oldest += PROFILE_DUMP_MARGIN;
+        for (uint64_t i = oldest; i < head; ++i) {
+            const ProfileEvent* e = &thread->events[i % PROFILE_RING_SIZE];
+            fputs(",\n{\"name\":", file);
+            profile_write_string(file, e->name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                thread->id, e->start / 1000.0, (e->end - e->start) / 1000.0);
+            ++events;
+        }
+    }
+    fputs("\n]}\n", file);
+    fclose(file);
+
+    TraceLog(LOG_INFO, "PROFILE: Wrote %d zones to %s", events, filename);
+    return true;
+}
+
+#endif
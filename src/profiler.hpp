@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+Scoped profiler, PROFILE_ZONE("name") times the rest of the enclosing block. Every thread writes its
+zones into its own ring buffer so recording takes no locks, the main thread marks frames with
+profile_frame_mark. The overlay shows the zones of the last frame on the main thread as a table and as
+a flame view, profile_dump_chrome writes everything still in the rings as Chrome trace event JSON that
+can be opened in Perfetto or chrome://tracing.
+
+Everything compiles to nothing unless ECONOMIA_PROFILE is defined. Zone names have to be string
+literals or otherwise outlive the profiler.
+*/
+
+#include <stdint.h>
+
+#define PROFILE_RING_SIZE 16384     // Zones kept per thread
+#define PROFILE_THREADS_MAX 32
+#define PROFILE_ZONES_MAX 64        // Distinct zone names shown in the overlay
+
+#if defined(ECONOMIA_PROFILE)
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(_profile_zone_, __LINE__)(name)
+
+// Nanoseconds from a monotonic clock
+uint64_t profile_now();
+
+void profile_zone_begin();
+void profile_zone_end(const char* name, uint64_t start);
+
+struct ProfileScope {
+    const char* name;
+    uint64_t start;
+
+    ProfileScope(const char* zone_name) : name(zone_name), start(profile_now()) { profile_zone_begin(); }
+    ~ProfileScope() { profile_zone_end(name, start); }
+};
+
+// Name shown for the calling thread in traces
+void profile_thread_name(const char* name);
+
+// Call at the start of every frame on the main thread
+void profile_frame_mark();
+
+// Table of zones and flame view of the last complete frame
+void profile_draw_overlay(int x, int y);
+
+bool profile_dump_chrome(const char* filename);
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+
+inline void profile_thread_name(const char*) {}
+inline void profile_frame_mark() {}
+inline void profile_draw_overlay(int, int) {}
+inline bool profile_dump_chrome(const char*) { return false; }
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+Fixed point amounts of goods, 16 integer and 16 fraction bits. Supply, demand and production are kept
+in these so the simulation only does integer math and gives the same result with every compiler, set
+of flags and machine, floats drift with FMA contraction and the order the compiler picks.
+
+A tile holds at most 32767 of a good, that's plenty and keeps Tile the size it was with floats. The
+math is done in 64 bits and saturates instead of wrapping, sums over many tiles should be kept in an
+int64_t.
+
+Floats only come in at the edges, the amounts set up for a tile type, the adjacency factors and the
+frame time are converted once. The conversion rounds to the nearest 1/65536, which is the same on
+every IEEE platform. Going back to float is for display only.
+*/
+
+#include <stdint.h>
+
+typedef int32_t Quantity;
+
+#define QUANTITY_SHIFT 16
+#define QUANTITY_ONE (1 << QUANTITY_SHIFT)
+#define QUANTITY_MAX INT32_MAX
+#define QUANTITY_MIN INT32_MIN
+
+static constexpr Quantity quantity_saturate(int64_t value)
+{
+    return (value > QUANTITY_MAX) ? QUANTITY_MAX : ((value < QUANTITY_MIN) ? QUANTITY_MIN : (Quantity)value);
+}
+
+static constexpr Quantity quantity_from_int(int value)
+{
+    return quantity_saturate((int64_t)value * QUANTITY_ONE);
+}
+
+static constexpr Quantity quantity_from_float(float value)
+{
+    return quantity_saturate((int64_t)(value * QUANTITY_ONE + ((value < 0.0f) ? -0.5f : 0.5f)));
+}
+
+static constexpr float quantity_to_float(Quantity value)
+{
+    return (float)value / QUANTITY_ONE;
+}
+
+// Takes the wide type so sums of quantities can be shown too
+static constexpr double quantity_to_double(int64_t value)
+{
+    return (double)value / QUANTITY_ONE;
+}
+
+// Whole units, rounded down
+static constexpr int quantity_to_int(Quantity value)
+{
+    return value >> QUANTITY_SHIFT;
+}
+
+static constexpr Quantity quantity_add(Quantity a, Quantity b)
+{
+    return quantity_saturate((int64_t)a + b);
+}
+
+static constexpr Quantity quantity_sub(Quantity a, Quantity b)
+{
+    return quantity_saturate((int64_t)a - b);
+}
+
+// Rounds towards negative infinity like the shift does
+static constexpr Quantity quantity_mul(Quantity a, Quantity b)
+{
+    return quantity_saturate(((int64_t)a * b) >> QUANTITY_SHIFT);
+}
+
+static constexpr Quantity quantity_clamp(Quantity value, Quantity min, Quantity max)
+{
+    return (value < min) ? min : ((value > max) ? max : value);
+}
+
+static_assert(quantity_from_float(1.0f) == QUANTITY_ONE);
+static_assert(quantity_from_float(-0.25f) == -QUANTITY_ONE / 4);
+static_assert(quantity_from_int(40000) == QUANTITY_MAX);
+static_assert(quantity_mul(quantity_from_int(3), quantity_from_float(0.5f)) == quantity_from_float(1.5f));
+static_assert(quantity_mul(quantity_from_int(300), quantity_from_int(300)) == QUANTITY_MAX);
+static_assert(quantity_add(QUANTITY_MAX, 1) == QUANTITY_MAX);
+static_assert(quantity_sub(QUANTITY_MIN, 1) == QUANTITY_MIN);
@@ -25,6 +25,11 @@
 #endif
 #include <crtdbg.h>
 #include "assets.hpp"
+#include "model_manager.hpp"
+#include "frame_pacing.hpp"
+#include "memory.hpp"
+#include "profiler.hpp"
+#include "telemetry.hpp"
 
 //----------------------------------------------------------------------------------
 // Shared Variables Definition (global)
@@ -35,14 +40,16 @@ Font font = { 0 };
 Music music = { 0 };
 Sound fxCoin = { 0 };
 
-Model *g_models;
-
 //----------------------------------------------------------------------------------
 // Local Variables Definition (local to this module)
 //----------------------------------------------------------------------------------
 static const int screenWidth = 800;
 static const int screenHeight = 450;
 
+static const double modelUploadBudget = 0.004;  // Seconds per frame spent uploading streamed models
+static bool showProfiler = false;               // F3 toggles the profiler overlay, F4 writes a trace
+static bool showMemory = false;                 // F5 toggles the memory overlay
+
 // Required variables to manage screen transitions (fade-in, fade-out)
 static float transAlpha = 0.0f;
 static bool onTransition = false;
@@ -75,11 +82,17 @@ int main(void)
 {
     // Initialization
     //---------------------------------------------------------
+    memory_hook_raylib();   // Before raylib allocates anything
     InitWindow(screenWidth, screenHeight, "raylib game template");
 
     InitAudioDevice();      // Initialize audio device
 
-    g_models = models_load_all();
+    // Models are streamed in on demand, the logo screen waits for the ones gameplay starts with
+    model_manager_init(MODEL_BUDGET_DEFAULT);
+    models_register_all();
+
+    // Simulation counters, a new row every 5 seconds, files rotate at 1MB
+    telemetry_start("telemetry.csv", TELEMETRY_CSV, 5.0, 1024 * 1024, 3);
 
     // Load global data (assets that must be available in all screens, i.e. font)
     // font = LoadFont("resources/mecha.png");
@@ -90,8 +103,8 @@ int main(void)
     // PlayMusicStream(music);
 
     // Setup and init first screen
-    currentScreen = GAMEPLAY;
-    init_gameplay_screen();
+    currentScreen = LOGO;
+    init_logo_screen();
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(update_draw_frame, 60, 1);
@@ -120,6 +133,9 @@ int main(void)
     }
 
     // Unload global data loaded
+    telemetry_stop();
+    model_manager_shutdown();
+    assets_unload_shaders();
     UnloadFont(font);
     UnloadMusicStream(music);
     UnloadSound(fxCoin);
@@ -127,6 +143,8 @@ int main(void)
     CloseAudioDevice();     // Close audio context
 
     CloseWindow();          // Close window and OpenGL context
+
+    memory_dump();          // Whatever is still allocated now leaks
     //--------------------------------------------------------------------------------------
 
     return 0;
@@ -240,17 +258,40 @@ static void update_draw_frame(void)
 {
     // Update
     //----------------------------------------------------------------------------------
+    profile_frame_mark();
+    PROFILE_ZONE("frame");
+
     UpdateMusicStream(music);       // NOTE: Music keeps playing between screens
 
+    pacing_begin_frame();
+
+    if (IsKeyPressed(KEY_F3)) showProfiler = !showProfiler;
+    if (IsKeyPressed(KEY_F4)) profile_dump_chrome("profile.json");
+    if (IsKeyPressed(KEY_F5)) showMemory = !showMemory;
+    if (showProfiler || showMemory) pacing_invalidate(REDRAW_ALWAYS);
+    memory_sample(GetTime());
+
+    // Only gameplay tracks its changes, everything else is animated
+    if ((currentScreen != GAMEPLAY) || onTransition) pacing_invalidate(REDRAW_ALWAYS);
+
+    // Placeholders are replaced as models finish streaming in
+    int resident = model_manager_stats().resident;
+    {
+        PROFILE_ZONE("model_manager_update");
+        model_manager_update(modelUploadBudget);
+    }
+    if (model_manager_stats().resident != resident) pacing_invalidate(REDRAW_STREAMING);
+
     if (!onTransition)
     {
+        PROFILE_ZONE("update");
         switch(currentScreen)
         {
             case LOGO:
             {
                 update_logo_screen();
 
-                if (finish_logo_screen()) fade_to_screen(TITLE);
+                if (finish_logo_screen()) fade_to_screen(GAMEPLAY);
 
             } break;
             case TITLE:
@@ -291,25 +332,41 @@ static void update_draw_frame(void)
 
     // Draw
     //----------------------------------------------------------------------------------
+    // Nothing changed, the last presented frame is still on screen
+    if (!pacing_should_draw())
+    {
+        pacing_idle();
+        return;
+    }
+
     BeginDrawing();
 
         ClearBackground(GRAY);
 
-        switch(currentScreen)
         {
-            case LOGO: draw_logo_screen(); break;
-            case TITLE: draw_title_screen(); break;
-            case OPTIONS: draw_options_screen(); break;
-            case GAMEPLAY: draw_gameplay_screen(); break;
-            case ENDING: draw_ending_screen(); break;
-            default: break;
-        }
+            PROFILE_ZONE("draw");
+            switch(currentScreen)
+            {
+                case LOGO: draw_logo_screen(); break;
+                case TITLE: draw_title_screen(); break;
+                case OPTIONS: draw_options_screen(); break;
+                case GAMEPLAY: draw_gameplay_screen(); break;
+                case ENDING: draw_ending_screen(); break;
+                default: break;
+            }
 
-        // Draw full screen rectangle in front of everything
-        if (onTransition) draw_transition();
+            // Draw full screen rectangle in front of everything
+            if (onTransition) draw_transition();
+        }
 
         //DrawFPS(10, 10);
+        if (showProfiler) profile_draw_overlay(GetScreenWidth() - 430, 10);
+        if (showMemory) memory_draw_overlay(10, GetScreenHeight() - 100);
 
-    EndDrawing();
+    {
+        PROFILE_ZONE("EndDrawing");
+        EndDrawing();
+    }
+    pacing_frame_drawn();
     //----------------------------------------------------------------------------------
 }
@@ -0,0 +1,226 @@
+#include "render_queue.hpp"
+#include "memory.hpp"
+
+#include "raymath.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+#define RENDER_MATERIALS_MAX 256
+#define RENDER_INSTANCED_MAX 8
+#define RENDER_DEPTH_FAR 1000.0f
+
+struct RenderPacket {
+    Mesh mesh;
+    Material material;
+    Matrix transform;
+    Color tint;
+};
+
+struct RenderSortEntry {
+    uint64_t key;
+    int index;
+};
+
+static RenderPacket* _packets = nullptr;
+static RenderSortEntry* _entries = nullptr;
+static Matrix* _transforms = nullptr;
+static int _packet_count = 0;
+static int _capacity = 0;
+
+static Vector3 _camera_position = { 0 };
+static RenderStats _stats = { 0 };
+
+// Materials are shared through the cache, so the maps pointer identifies the material state
+static const MaterialMap* _material_ids[RENDER_MATERIALS_MAX] = { 0 };
+static int _material_id_count = 0;
+
+static Shader _instanced_from[RENDER_INSTANCED_MAX] = { 0 };
+static Shader _instanced_to[RENDER_INSTANCED_MAX] = { 0 };
+static int _instanced_count = 0;
+
+void render_queue_init()
+{
+    _capacity = 1024;
+    _packets = (RenderPacket*)memory_calloc(MEMORY_TAG_RENDER, _capacity, sizeof(RenderPacket));
+    _entries = (RenderSortEntry*)memory_calloc(MEMORY_TAG_RENDER, _capacity, sizeof(RenderSortEntry));
+    _transforms = (Matrix*)memory_calloc(MEMORY_TAG_RENDER, _capacity, sizeof(Matrix));
+    _packet_count = 0;
+}
+
+void render_queue_unload()
+{
+    memory_free(_packets);
+    memory_free(_entries);
+    memory_free(_transforms);
+    _packets = nullptr;
+    _entries = nullptr;
+    _transforms = nullptr;
+    _capacity = 0;
+    _packet_count = 0;
+}
+
+void render_queue_begin(Camera3D camera)
+{
+    _camera_position = camera.position;
+    _packet_count = 0;
+    _material_id_count = 0;
+}
+
+// The vertex buffer tells meshes apart, vaoId is 0 for all of them where VAOs aren't supported
+static unsigned int render_mesh_id(const Mesh* mesh)
+{
+    return (mesh->vboId != nullptr) ? mesh->vboId[0] : 0;
+}
+
+static unsigned int render_material_id(const Material* material)
+{
+    for (int i = 0; i < _material_id_count; ++i) {
+        if (_material_ids[i] == material->maps) return i;
+    }
+    if (_material_id_count >= RENDER_MATERIALS_MAX) return RENDER_MATERIALS_MAX;
+    _material_ids[_material_id_count] = material->maps;
+    return _material_id_count++;
+}
+
+// Doubles the storage, only happens until the busiest frame has been seen once
+static bool render_queue_grow()
+{
+    int capacity = (_capacity > 0) ? _capacity * 2 : 1024;
+    RenderPacket* packets = (RenderPacket*)memory_realloc(MEMORY_TAG_RENDER, _packets, capacity * sizeof(RenderPacket));
+    if (packets != nullptr) _packets = packets;
+    RenderSortEntry* entries = (RenderSortEntry*)memory_realloc(MEMORY_TAG_RENDER, _entries, capacity * sizeof(RenderSortEntry));
+    if (entries != nullptr) _entries = entries;
+    Matrix* transforms = (Matrix*)memory_realloc(MEMORY_TAG_RENDER, _transforms, capacity * sizeof(Matrix));
+    if (transforms != nullptr) _transforms = transforms;
+
+    if (packets == nullptr || entries == nullptr || transforms == nullptr) {
+        TraceLog(LOG_WARNING, "RENDER: Failed to grow the render queue to %d packets", capacity);
+        return false;
+    }
+    _capacity = capacity;
+    return true;
+}
+
+void render_queue_model(const Model* model, Vector3 position, Vector3 axis, float angle, Vector3 scale, Color tint)
+{
+    // Same transform as DrawModelEx
+    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
+    Matrix matRotation = MatrixRotate(axis, angle*DEG2RAD);
+    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
+    Matrix transform = MatrixMultiply(model->transform, matTransform);
+
+    float distance = Vector3Distance(position, _camera_position);
+    unsigned int depth = (unsigned int)(Clamp(distance/RENDER_DEPTH_FAR, 0.0f, 1.0f)*0xffff);
+
+    for (int i = 0; i < model->meshCount; ++i) {
+        if (_packet_count >= _capacity && !render_queue_grow()) return;
+
+        const Material* material = &model->materials[model->meshMaterial[i]];
+        RenderPacket* packet = &_packets[_packet_count];
+        packet->mesh = model->meshes[i];
+        packet->material = *material;
+        packet->transform = transform;
+        packet->tint = tint;
+
+        _entries[_packet_count].key = render_key(material->shader.id, render_material_id(material),
+            render_mesh_id(&model->meshes[i]), depth);
+        _entries[_packet_count].index = _packet_count;
+        ++_packet_count;
+    }
+}
+
+static bool render_same_batch(const RenderPacket* a, const RenderPacket* b)
+{
+    return render_mesh_id(&a->mesh) == render_mesh_id(&b->mesh) && a->material.maps == b->material.maps &&
+        a->material.shader.id == b->material.shader.id &&
+        a->tint.r == b->tint.r && a->tint.g == b->tint.g && a->tint.b == b->tint.b && a->tint.a == b->tint.a;
+}
+
+static Shader render_instanced_shader(Shader shader)
+{
+    for (int i = 0; i < _instanced_count; ++i) {
+        if (_instanced_from[i].id == shader.id) return _instanced_to[i];
+    }
+    return Shader{ 0 };
+}
+
+static void render_draw(const RenderPacket* packet)
+{
+    // Tint the same way DrawModelEx does
+    Color color = packet->material.maps[MATERIAL_MAP_DIFFUSE].color;
+    Color tinted = color;
+    tinted.r = (unsigned char)(((int)color.r*(int)packet->tint.r)/255);
+    tinted.g = (unsigned char)(((int)color.g*(int)packet->tint.g)/255);
+    tinted.b = (unsigned char)(((int)color.b*(int)packet->tint.b)/255);
+    tinted.a = (unsigned char)(((int)color.a*(int)packet->tint.a)/255);
+
+    packet->material.maps[MATERIAL_MAP_DIFFUSE].color = tinted;
+    DrawMesh(packet->mesh, packet->material, packet->transform);
+    packet->material.maps[MATERIAL_MAP_DIFFUSE].color = color;
+}
+
+void render_queue_flush()
+{
+    _stats = RenderStats{ 0 };
+    _stats.packets = _packet_count;
+
+    std::sort(_entries, _entries + _packet_count,
+        [](const RenderSortEntry& a, const RenderSortEntry& b) { return a.key < b.key; });
+
+    const RenderPacket* previous = nullptr;
+    int i = 0;
+    while (i < _packet_count) {
+        const RenderPacket* packet = &_packets[_entries[i].index];
+
+        if (previous == nullptr || previous->material.shader.id != packet->material.shader.id) ++_stats.shader_changes;
+        if (previous == nullptr || previous->material.maps != packet->material.maps) ++_stats.material_changes;
+        if (previous == nullptr || render_mesh_id(&previous->mesh) != render_mesh_id(&packet->mesh)) ++_stats.mesh_changes;
+        previous = packet;
+
+        int run = 1;
+        while (i + run < _packet_count && render_same_batch(packet, &_packets[_entries[i + run].index])) ++run;
+
+        Shader instanced = render_instanced_shader(packet->material.shader);
+        bool white = packet->tint.r == 255 && packet->tint.g == 255 && packet->tint.b == 255 && packet->tint.a == 255;
+        if (run > 1 && instanced.id != 0 && white) {
+            for (int j = 0; j < run; ++j) {
+                _transforms[j] = _packets[_entries[i + j].index].transform;
+            }
+            Material material = packet->material;
+            material.shader = instanced;
+            DrawMeshInstanced(packet->mesh, material, _transforms, run);
+            ++_stats.instanced_draws;
+            ++_stats.draws;
+        }
+        else {
+            for (int j = 0; j < run; ++j) {
+                render_draw(&_packets[_entries[i + j].index]);
+                ++_stats.draws;
+            }
+        }
+        i += run;
+    }
+
+    _packet_count = 0;
+}
+
+RenderStats render_queue_stats()
+{
+    return _stats;
+}
+
+void render_queue_set_instanced_shader(Shader shader, Shader instanced)
+{
+    for (int i = 0; i < _instanced_count; ++i) {
+        if (_instanced_from[i].id == shader.id) {
+            _instanced_to[i] = instanced;
+            return;
+        }
+    }
+    if (_instanced_count >= RENDER_INSTANCED_MAX) return;
+    _instanced_from[_instanced_count] = shader;
+    _instanced_to[_instanced_count] = instanced;
+    ++_instanced_count;
+}
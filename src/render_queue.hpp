@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+Render queue, instead of drawing models right away draw packets are collected for the frame,
+sorted by a key made of shader, material, mesh and depth and then submitted in that order.
+Runs of packets that share mesh and material are drawn instanced when the material's shader has
+an instanced variant.
+*/
+
+#include "raylib.h"
+
+#include <stdint.h>
+
+// Key layout from most to least significant: shader 12 bits, material 16 bits, mesh 20 bits, depth 16 bits
+constexpr uint64_t render_key(unsigned int shader, unsigned int material, unsigned int mesh, unsigned int depth)
+{
+    return ((uint64_t)(shader & 0xfff) << 52) | ((uint64_t)(material & 0xffff) << 36) |
+        ((uint64_t)(mesh & 0xfffff) << 16) | (uint64_t)(depth & 0xffff);
+}
+
+struct RenderStats {
+    int packets;
+    int draws;              // Calls into raylib, an instanced batch counts once
+    int instanced_draws;
+    int shader_changes;
+    int material_changes;
+    int mesh_changes;
+};
+
+void render_queue_init();
+void render_queue_unload();
+
+// Starts collecting packets, depth is measured from the camera position
+void render_queue_begin(Camera3D camera);
+
+// Queues all meshes of a model, same parameters as DrawModelEx
+void render_queue_model(const Model* model, Vector3 position, Vector3 axis, float angle, Vector3 scale, Color tint);
+
+// Sorts the packets and draws them, has to be called inside BeginMode3D
+void render_queue_flush();
+
+// Counters of the last flush
+RenderStats render_queue_stats();
+
+// Materials using shader are drawn with instanced in runs of identical meshes
+void render_queue_set_instanced_shader(Shader shader, Shader instanced);
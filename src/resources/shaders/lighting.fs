@@ -15,23 +15,39 @@ out vec4 finalColor;
 
 // NOTE: Add here your custom variables
 
-#define     MAX_LIGHTS              4
-#define     LIGHT_DIRECTIONAL       0
-#define     LIGHT_POINT             1
+// The light setup is compiled in, one program per combination (see shader_variants.cpp).
+// Directional lights come first in the lights array, followed by the point lights
+#ifndef DIRECTIONAL_LIGHTS
+#define     DIRECTIONAL_LIGHTS      1
+#endif
+#ifndef POINT_LIGHTS
+#define     POINT_LIGHTS            0
+#endif
+#define     LIGHT_COUNT             (DIRECTIONAL_LIGHTS + POINT_LIGHTS)
 
 struct Light {
-    int enabled;
-    int type;
     vec3 position;
     vec3 target;
     vec4 color;
 };
 
 // Input lighting values
-uniform Light lights[MAX_LIGHTS];
+#if LIGHT_COUNT > 0
+uniform Light lights[LIGHT_COUNT];
+#endif
 uniform vec4 ambient;
 uniform vec3 viewPos;
 
+void add_light(vec3 light, vec3 color, vec3 normal, vec3 viewD, inout vec3 lightDot, inout vec3 specular)
+{
+    float NdotL = max(dot(normal, light), 0.0);
+    lightDot += color*NdotL;
+
+    float specCo = 0.0;
+    if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
+    specular += specCo;
+}
+
 void main()
 {
     // Texel color fetching from texture sampler
@@ -43,30 +59,21 @@ void main()
 
     // NOTE: Implement here your fragment shader code
 
-    for (int i = 0; i < MAX_LIGHTS; i++)
+#if DIRECTIONAL_LIGHTS > 0
+    for (int i = 0; i < DIRECTIONAL_LIGHTS; i++)
     {
-        if (lights[i].enabled == 1)
-        {
-            vec3 light = vec3(0.0);
-
-            if (lights[i].type == LIGHT_DIRECTIONAL)
-            {
-                light = -normalize(lights[i].target - lights[i].position);
-            }
-
-            if (lights[i].type == LIGHT_POINT)
-            {
-                light = normalize(lights[i].position - fragPosition);
-            }
-
-            float NdotL = max(dot(normal, light), 0.0);
-            lightDot += lights[i].color.rgb*NdotL;
+        vec3 light = -normalize(lights[i].target - lights[i].position);
+        add_light(light, lights[i].color.rgb, normal, viewD, lightDot, specular);
+    }
+#endif
 
-            float specCo = 0.0;
-            if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
-            specular += specCo;
-        }
+#if POINT_LIGHTS > 0
+    for (int i = DIRECTIONAL_LIGHTS; i < LIGHT_COUNT; i++)
+    {
+        vec3 light = normalize(lights[i].position - fragPosition);
+        add_light(light, lights[i].color.rgb, normal, viewD, lightDot, specular);
     }
+#endif
 
     finalColor = (texelColor*((colDiffuse + vec4(specular, 1.0))*vec4(lightDot, 1.0)));
     finalColor += texelColor*(ambient/10.0)*colDiffuse;
@@ -6,6 +6,27 @@ in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
 
+#ifndef INSTANCING
+#define INSTANCING 0
+#endif
+
+#ifndef VERTEX_ANIMATION
+#define VERTEX_ANIMATION 0
+#endif
+
+#if INSTANCING
+in mat4 instanceTransform;
+#endif
+
+#if VERTEX_ANIMATION
+// Baked vertex positions and normals, every frame is a block of rows, vertex i sits at
+// (i % width, i / width) inside of its block
+uniform sampler2D vatPositions;
+uniform sampler2D vatNormals;
+uniform vec4 vatLayout;         // Texture width, rows per frame, time in seconds, frames per second
+uniform vec2 vatClips[32];      // First frame and frame count of each clip
+#endif
+
 // Input uniform values
 uniform mat4 mvp;
 uniform mat4 matModel;
@@ -19,14 +40,51 @@ out vec3 fragNormal;
 
 // NOTE: Add here your custom variables
 
+#if VERTEX_ANIMATION
+vec3 vat_fetch(sampler2D source, int frame)
+{
+    int width = int(vatLayout.x);
+    ivec2 texel = ivec2(gl_VertexID % width, frame*int(vatLayout.y) + gl_VertexID/width);
+    return texelFetch(source, texel, 0).xyz;
+}
+#endif
+
 void main()
 {
+    vec3 position = vertexPosition;
+    vec3 normal = vertexNormal;
+
+#if VERTEX_ANIMATION
+    // Clip index and time offset are stored in the bottom row of the instance transform
+    vec2 clip = vatClips[int(instanceTransform[0][3])];
+    float frame = mod((vatLayout.z + instanceTransform[1][3])*vatLayout.w, clip.y);
+    int frame0 = int(clip.x) + int(frame);
+    int frame1 = int(clip.x) + int(mod(floor(frame) + 1.0, clip.y));
+    position = mix(vat_fetch(vatPositions, frame0), vat_fetch(vatPositions, frame1), fract(frame));
+    normal = mix(vat_fetch(vatNormals, frame0), vat_fetch(vatNormals, frame1), fract(frame));
+#endif
+
+#if INSTANCING
+    // raylib passes view*projection as mvp for instanced draws
+    mat4 model = instanceTransform;
+    model[0][3] = 0.0;
+    model[1][3] = 0.0;
+    model[2][3] = 0.0;
+    model[3][3] = 1.0;
+    mat3 normalMatrix = transpose(inverse(mat3(model)));
+    vec4 worldPosition = model*vec4(position, 1.0);
+#else
+    mat4 model = matModel;
+    mat3 normalMatrix = mat3(matNormal);
+    vec4 worldPosition = vec4(position, 1.0);
+#endif
+
     // Send vertex attributes to fragment shader
-    fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));
+    fragPosition = vec3(model*vec4(position, 1.0));
     fragTexCoord = vertexTexCoord;
     fragColor = vertexColor;
-    fragNormal = normalize(vec3(matNormal*vec4(vertexNormal, 1.0)));
+    fragNormal = normalize(normalMatrix*normal);
 
     // Calculate final vertex position
-    gl_Position = mvp*vec4(vertexPosition, 1.0);
+    gl_Position = mvp*worldPosition;
 }
@@ -0,0 +1,137 @@
+#pragma once
+
+/*
+Counter based random numbers, header only. There is no state that moves forward, every number is a
+function of where it is used, the world seed, a stream, the tick and the tile index or person id:
+
+    uint32_t roll = rng_below(world->seed, RNG_STREAM_HARVEST, world->tick, tile_index, 100);
+
+The same key always gives the same number, so ticks can visit tiles in any order or split them over
+threads and still come out the same. Streams keep unrelated uses apart, harvests and events on the
+same tile don't see the same numbers.
+
+The generator is Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"), the
+counter is index, tick, stream and 0, the key is the seed. Each call gives four 32 bit words, rng_u32
+and the helpers use the first one. rng_u32_batch fills an array for consecutive indices, four at a
+time with SSE2, and gives the same numbers as rng_u32.
+*/
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RNG_SSE2
+#include <emmintrin.h>
+#endif
+
+#define RNG_PHILOX_M0 0xD2511F53u
+#define RNG_PHILOX_M1 0xCD9E8D57u
+#define RNG_PHILOX_W0 0x9E3779B9u
+#define RNG_PHILOX_W1 0xBB67AE85u
+#define RNG_PHILOX_ROUNDS 10
+
+// Every use of random numbers gets its own stream
+enum RngStream {
+    RNG_STREAM_HARVEST,
+    RNG_STREAM_EVENT,
+    RNG_STREAM_PERSON,
+    RNG_STREAM_COUNT
+};
+
+struct RngBlock {
+    uint32_t v[4];
+};
+
+constexpr RngBlock rng_philox(RngBlock counter, uint64_t key)
+{
+    uint32_t k0 = (uint32_t)key;
+    uint32_t k1 = (uint32_t)(key >> 32);
+    for (int i = 0; i < RNG_PHILOX_ROUNDS; ++i) {
+        uint64_t p0 = (uint64_t)RNG_PHILOX_M0 * counter.v[0];
+        uint64_t p1 = (uint64_t)RNG_PHILOX_M1 * counter.v[2];
+        counter = RngBlock{ {
+            (uint32_t)(p1 >> 32) ^ counter.v[1] ^ k0,
+            (uint32_t)p1,
+            (uint32_t)(p0 >> 32) ^ counter.v[3] ^ k1,
+            (uint32_t)p0 } };
+        k0 += RNG_PHILOX_W0;
+        k1 += RNG_PHILOX_W1;
+    }
+    return counter;
+}
+
+constexpr RngBlock rng_block(uint64_t seed, uint32_t stream, uint32_t tick, uint32_t index)
+{
+    return rng_philox(RngBlock{ { index, tick, stream, 0 } }, seed);
+}
+
+constexpr uint32_t rng_u32(uint64_t seed, uint32_t stream, uint32_t tick, uint32_t index)
+{
+    return rng_block(seed, stream, tick, index).v[0];
+}
+
+// 0 to bound - 1, the bias is below bound / 2^32
+constexpr uint32_t rng_below(uint64_t seed, uint32_t stream, uint32_t tick, uint32_t index, uint32_t bound)
+{
+    return (uint32_t)(((uint64_t)rng_u32(seed, stream, tick, index) * bound) >> 32);
+}
+
+// 0 to 1 with 24 bits, exactly representable so it's the same on every machine
+constexpr float rng_unit(uint64_t seed, uint32_t stream, uint32_t tick, uint32_t index)
+{
+    return (float)(rng_u32(seed, stream, tick, index) >> 8) * (1.0f / 16777216.0f);
+}
+
+// 0 to 1 as the raw value of a 16.16 fixed point Quantity, see quantity.hpp
+constexpr int32_t rng_fraction(uint64_t seed, uint32_t stream, uint32_t tick, uint32_t index)
+{
+    return (int32_t)(rng_u32(seed, stream, tick, index) >> 16);
+}
+
+#if defined(RNG_SSE2)
+// Low and high halves of the 32x32 bit products of four lanes with m
+static inline void rng_mulhilo_sse2(__m128i a, __m128i m, __m128i* lo, __m128i* hi)
+{
+    const __m128i low_mask = _mm_set1_epi64x(0xFFFFFFFFll);
+    __m128i even = _mm_mul_epu32(a, m);                         // Lanes 0 and 2
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);      // Lanes 1 and 3
+    *lo = _mm_or_si128(_mm_and_si128(even, low_mask), _mm_slli_epi64(odd, 32));
+    *hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low_mask, odd));
+}
+#endif
+
+// out[i] = rng_u32(seed, stream, tick, first + i)
+inline void rng_u32_batch(uint64_t seed, uint32_t stream, uint32_t tick, uint32_t first, uint32_t* out, int count)
+{
+    int i = 0;
+#if defined(RNG_SSE2)
+    const __m128i m0 = _mm_set1_epi32((int)RNG_PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int)RNG_PHILOX_M1);
+    for (; i + 4 <= count; i += 4) {
+        // One counter per lane, c0 holds the four indices
+        __m128i c0 = _mm_add_epi32(_mm_set1_epi32((int)(first + i)), _mm_setr_epi32(0, 1, 2, 3));
+        __m128i c1 = _mm_set1_epi32((int)tick);
+        __m128i c2 = _mm_set1_epi32((int)stream);
+        __m128i c3 = _mm_setzero_si128();
+        uint32_t k0 = (uint32_t)seed;
+        uint32_t k1 = (uint32_t)(seed >> 32);
+        for (int round = 0; round < RNG_PHILOX_ROUNDS; ++round) {
+            __m128i lo0, hi0, lo1, hi1;
+            rng_mulhilo_sse2(c0, m0, &lo0, &hi0);
+            rng_mulhilo_sse2(c2, m1, &lo1, &hi1);
+            c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32((int)k0));
+            c1 = lo1;
+            c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32((int)k1));
+            c3 = lo0;
+            k0 += RNG_PHILOX_W0;
+            k1 += RNG_PHILOX_W1;
+        }
+        _mm_storeu_si128((__m128i*)&out[i], c0);
+    }
+#endif
+    for (; i < count; ++i) out[i] = rng_u32(seed, stream, tick, first + (uint32_t)i);
+}
+
+// Known answers from the Random123 distribution
+static_assert(rng_philox(RngBlock{ { 0, 0, 0, 0 } }, 0).v[0] == 0x6627e8d5u);
+static_assert(rng_philox(RngBlock{ { 0, 0, 0, 0 } }, 0).v[3] == 0x9b00dbd8u);
+static_assert(rng_philox(RngBlock{ { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu } }, ~0ull).v[0] == 0x408f276du);
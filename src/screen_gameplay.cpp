@@ -29,10 +29,23 @@
 
 #include "screens.h"
 #include "assets.hpp"
+#include "model_manager.hpp"
+#include "render_queue.hpp"
+#include "frame_pacing.hpp"
+#include "vertex_animation.hpp"
+#include "minimap.hpp"
+#include "heatmap.hpp"
+#include "hud.hpp"
+#include "format.hpp"
+#include "profiler.hpp"
 #include "world.hpp"
+#include "autotile.hpp"
+#include "hex.hpp"
+#include "picking.hpp"
 
 #include <crtdbg.h>
 #include <assert.h>
+#include <string.h>
 
 //----------------------------------------------------------------------------------
 // Module Variables Definition (local)
@@ -46,8 +59,14 @@ static int _editor_tiles[ECONOMY_TILE_COUNT * 2] = {
     ECONOMY_TILE_FARM, MODEL_BUILDING_FARM,
     ECONOMY_TILE_HOUSE, MODEL_BUILDING_HOUSE,
     ECONOMY_TILE_FOREST, MODEL_BUILDING_FOREST,
+    ECONOMY_TILE_ROAD, MODEL_PATH_END,
+    ECONOMY_TILE_RIVER, MODEL_RIVER_END,
 };
 
+// Path models only contain the path, they are drawn on top of a grass tile
+static const float _path_height = 0.2f;
+static const float _building_height = 1.0f;    // Picking bound for tiles with a building on top
+
 
 enum Actions {
     ACTION_CURSOR_LEFT = KEY_LEFT,
@@ -72,11 +91,6 @@ enum Actions {
 Camera3D _camera3D = { 0 };
 Camera2D _camera2D = { 0 };
 
-struct Hex {
-    int r;
-    int q;
-};
-
 struct Cursor {
     Hex hex;
     Tile tile;
@@ -93,40 +107,47 @@ struct Game {
 static constexpr int _board_size = 7;
 static Tile _tiles[_board_size][_board_size] = {0};
 
-static const float _size = 1.0f / sqrtf(3.0);
+static constexpr float _size = 1.0f / HEX_SQRT3;
 static Vector3 _origin;
 
 Game _game;
-// For hex functions see https://www.redblobgames.com/grids/hexagons/
-
-
-struct Layout {
-    Vector2 _origin;
-    
-};
-
-Vector2 flat_hex_to_pixel(int q, int r, float _size) 
-{
-    float x = _size * (3. / 2 * q);
-    float y = _size * (sqrt(3) / 2 * q + sqrt(3) * r);
-    return Vector2(x, y);
-}
-
-
-constexpr Vector3 pointy_hex_to_pixel(int q, int r, float _size)
-{
-    constexpr float sqrt3 = 1.73205080757;
-    float x = _size * (sqrt3 * q + sqrt3 / 2 * r);
-    float y = _size * (3. / 2 * r);
-    return Vector3(x, 0, y);
-}
 
+static bool _show_info = false;
+static bool _on_demand = true;      // Only redraw when something changed
+static bool _show_heatmap = false;
+static int _heatmap_mode = 0;       // HeatmapMetric * GOOD_COUNT + Good, only supply until a recipe has demand
+static int _drawn_revision = -1;    // World revision that is on screen
+
+// Retained HUD, texts are formatted in update and only when what they show changed
+static HudText _hud_draws = { 0 };
+static HudText _hud_changes = { 0 };
+static HudText _hud_tile_info = { 0 };
+static HudPanel _hud_tile_panel = { 0 };
+static bool gameplay_screen_update_hud();
+
+// People are drawn from baked vertex animation once the character model is in memory
+static const char* _crowd_clips[] = { "idle", "walk", "emote-yes", "interact-right" };
+static VertexAnimation _crowd = { 0 };
+static bool _crowd_baked = false;      // Only try once, a failed bake falls back to static people
+static float _crowd_time = 0.0f;
 void draw_coords(Vector3 _origin, float _size = 1) {
     DrawLine3D(_origin, _origin + Vector3(_size, 0, 0), RED);
     DrawLine3D(_origin, _origin + Vector3(0, _size, 0), GREEN);
     DrawLine3D(_origin, _origin + Vector3(0, 0, _size), BLUE);
 }
 
+// Mouse picking ignores the mouse while it is over the settings
+static const Rectangle _settings_bounds = { 20, 20, 200, 200 };
+
+// The minimap sits in the bottom right corner, rows of hexes are closer together than columns
+static Rectangle minimap_bounds()
+{
+    const float width = 200.0f;
+    Vector2 size = minimap_size();
+    float height = (size.x > 0) ? width * size.y / size.x * 0.866f : 0.0f;
+    return Rectangle{ GetScreenWidth() - width - 20, GetScreenHeight() - height - 20, width, height };
+}
+
 void process_input(Camera3D* camera, float dt)
 {
     float change = GetMouseWheelMove();
@@ -135,6 +156,16 @@ void process_input(Camera3D* camera, float dt)
 
     Cursor cursor = _game.cursor;
 
+    // The cursor follows the mouse unless it is over the GUI, the arrow keys still move it
+    Vector2 mouse = GetMousePosition();
+    Vector2 delta = GetMouseDelta();
+    Hex picked = { 0 };
+    if ((delta.x != 0 || delta.y != 0) && !CheckCollisionPointRec(mouse, _settings_bounds) &&
+        !CheckCollisionPointRec(mouse, minimap_bounds()) && picking_pick(GetMouseRay(mouse, *camera), &picked))
+    {
+        cursor.hex = picked;
+    }
+
     int key = GetKeyPressed();
     switch (key) {
     case ACTION_CURSOR_LEFT:
@@ -161,6 +192,14 @@ void process_input(Camera3D* camera, float dt)
     case ACTION_PLACE_TILE:
         _tiles[cursor.hex.q][cursor.hex.r] = cursor.tile;
         world_add_tile(_game.world, cursor.tile, cursor.hex.q, cursor.hex.r);
+        // Flat tiles lower the hex again when they replace a building
+        if (cursor.tile.type == ECONOMY_TILE_FARM || cursor.tile.type == ECONOMY_TILE_FOREST ||
+            cursor.tile.type == ECONOMY_TILE_HOUSE)
+        {
+            picking_set_height(cursor.hex, _building_height);
+        } else {
+            picking_set_height(cursor.hex, _path_height);
+        }
         break;
     case ACTION_PERSON_PLACE:
     {
@@ -187,6 +226,7 @@ void process_input(Camera3D* camera, float dt)
         if (_game.selected_person != nullptr) {
             _game.selected_person->q = cursor.hex.q;
             _game.selected_person->r = cursor.hex.r;
+            pacing_invalidate(REDRAW_PEOPLE);
         }
         break;
     }
@@ -194,19 +234,30 @@ void process_input(Camera3D* camera, float dt)
 
     if (IsKeyDown(ACTION_CAMERA_LEFT))
     {
-        Vector3 mov = Vector3(10, 0, 0) * GetFrameTime();
+        Vector3 mov = Vector3(10, 0, 0) * dt;
         _camera3D.position += mov;
         _camera3D.target += mov;
     }
     if (IsKeyDown(ACTION_CAMERA_RIGHT)) 
     {
-        Vector3 mov = Vector3(-10, 0, 0) * GetFrameTime();
+        Vector3 mov = Vector3(-10, 0, 0) * dt;
         _camera3D.position += mov;
         _camera3D.target += mov;
     }
 
+    // Clicking the minimap centers the camera on that hex
+    int map_q = 0, map_r = 0;
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && minimap_pick(minimap_bounds(), GetMousePosition(), &map_q, &map_r))
+    {
+        Vector3 target = hex_to_world(Hex{ map_q, map_r }, _size) + _origin;
+        _camera3D.position += target - _camera3D.target;
+        _camera3D.target = target;
+    }
+
+    if (key != 0 || cursor.hex != _game.cursor.hex) pacing_invalidate(REDRAW_INPUT);
+
     if (_game.cursor.hex.q != cursor.hex.q || _game.cursor.hex.r != cursor.hex.r) {
-        Vector3 coords = pointy_hex_to_pixel(cursor.hex.q, cursor.hex.r, 1.0f);
+        Vector3 coords = hex_to_world(cursor.hex, 1.0f);
         TraceLog(LOG_DEBUG, "Cursor: %d/%d %f|%f|%f", cursor.hex.q, cursor.hex.r, coords.x, coords.y, coords.z);
     }
     _game.cursor = cursor;
@@ -242,24 +293,55 @@ void init_gameplay_screen(void)
     }
 
     _game.world = world_create(_board_size, _board_size);
-    _origin = pointy_hex_to_pixel(-3, -3, _size);
+    _drawn_revision = -1;
+    minimap_init(_game.world);
+    render_queue_init();
+    _origin = hex_to_world(Hex{ -3, -3 }, _size);
+    heatmap_init(_game.world, _origin, _size);
+    picking_init(_game.world, _origin, _size, _path_height);
 }
 
 // Gameplay Screen Update logic
 void update_gameplay_screen(void)
 {
-    process_input(&_camera3D, GetFrameTime());
-    world_update(_game.world, GetFrameTime());
+    PROFILE_ZONE("gameplay_update");
 
-    // Update Model animations
-    //int anim = 2;
+    // Frame time is measured by the pacing, frames that aren't drawn still advance the simulation
+    float dt = pacing_frame_time();
+    Camera3D camera = _camera3D;
+    {
+        PROFILE_ZONE("process_input");
+        process_input(&_camera3D, dt);
+    }
+    {
+        PROFILE_ZONE("world_update");
+        world_update(_game.world, dt);
+    }
+    if (minimap_update(_game.world) > 0) pacing_invalidate(REDRAW_HUD);
+    if (heatmap_set_enabled(_game.world, _show_heatmap)) pacing_invalidate(REDRAW_WORLD);
+    if (heatmap_set_metric(_game.world, _heatmap_mode / GOOD_COUNT, _heatmap_mode % GOOD_COUNT)) pacing_invalidate(REDRAW_WORLD);
+    if (heatmap_update(_game.world) > 0) pacing_invalidate(REDRAW_WORLD);
+
+    if (memcmp(&camera, &_camera3D, sizeof(Camera3D)) != 0) pacing_invalidate(REDRAW_CAMERA);
+    if (_game.world->revision != _drawn_revision) pacing_invalidate(REDRAW_WORLD);
+
+    if (gameplay_screen_update_hud()) pacing_invalidate(REDRAW_HUD);
+    pacing_set_enabled(_on_demand);
 
-    //frame_count = (frame_count + 1) % animations[anim].frameCount;
+    // The next tile in the editor cycle is likely to be placed soon
+    int next_type = (_game.cursor.tile.type + 1) % ECONOMY_TILE_COUNT;
+    model_manager_prefetch(_editor_tiles[next_type*2 + 1]);
 
-    //if (_tiles[_game.cursor.hex.q][_game.cursor.hex.r].type != -1) {
-    //    TraceLog(LOG_INFO, world_get_tile_info(_game.world,  
-    //        _game.cursor.hex.q, _game.cursor.hex.r));
-    //}
+    // Update Model animations
+    if (!_crowd_baked && vat_supported() && _game.world->people_count > 0 &&
+        model_manager_is_ready(MODEL_CHARACTER_FEMALE))
+    {
+        _crowd_baked = true;
+        vat_bake(&_crowd, model_manager_get(MODEL_CHARACTER_FEMALE), model_path(MODEL_CHARACTER_FEMALE),
+            _crowd_clips, sizeof(_crowd_clips)/sizeof(_crowd_clips[0]));
+    }
+    _crowd_time += dt;
+    if (vat_ready(&_crowd) && _game.world->people_count > 0) pacing_invalidate(REDRAW_PEOPLE);
 
     // TODO: Update GAMEPLAY screen variables here!
 
@@ -270,59 +352,111 @@ void update_gameplay_screen(void)
         PlaySound(fxCoin);
     }
 
+    // Everything that follows the world's changes has seen them
+    world_clear_changes(_game.world);
+
+}
+
+// Formats the HUD texts whose values changed at display precision, returns true if any did
+static bool gameplay_screen_update_hud()
+{
+    bool changed = false;
+
+    RenderStats stats = render_queue_stats();
+    if (hud_text_stale(&_hud_draws, hud_key(hud_key(0, stats.draws), stats.instanced_draws))) {
+        hud_text_format(&_hud_draws, "Draws: %d (%d instanced)", stats.draws, stats.instanced_draws);
+        changed = true;
+    }
+    unsigned int key = hud_key(hud_key(hud_key(0, stats.shader_changes), stats.material_changes), stats.mesh_changes);
+    if (hud_text_stale(&_hud_changes, key)) {
+        hud_text_format(&_hud_changes, "Changes: %d shader %d mat %d mesh",
+            stats.shader_changes, stats.material_changes, stats.mesh_changes);
+        changed = true;
+    }
+
+    // The info panel shows whole numbers, only a change in those needs new text
+    if (_show_info) {
+        const World* world = _game.world;
+        const Tile* t = world_get_tile(_game.world, _game.cursor.hex.q, _game.cursor.hex.r);
+        int supply[GOOD_COUNT] = { 0 };
+        float modifier = 1.0f;
+        for (int i = 0; t != nullptr && i < GOOD_COUNT; ++i) {
+            int stock = world_find_stock(world, t, i);
+            if (stock < 0) continue;
+            supply[i] = quantity_to_int(world->stocks[stock].supply);
+            modifier = quantity_to_float(world->stock_info[stock].production_modifier);
+        }
+        key = hud_key(hud_key(0, _game.cursor.hex.q), _game.cursor.hex.r);
+        for (int i = 0; i < GOOD_COUNT; ++i) key = hud_key(key, supply[i]);
+        key = hud_key(key, (int)(modifier * 100));
+        if (t != nullptr && hud_text_stale(&_hud_tile_info, key)) {
+            format_append(_hud_tile_info.text, HUD_TEXT_MAX, &_hud_tile_info.length, "Goods:\n%d", supply[0]);
+            for (int i = 1; i < GOOD_COUNT; ++i) {
+                format_append(_hud_tile_info.text, HUD_TEXT_MAX, &_hud_tile_info.length, "/%d", supply[i]);
+            }
+            if (modifier != 1.0f) {
+                format_append(_hud_tile_info.text, HUD_TEXT_MAX, &_hud_tile_info.length, "\nNeighbors: x%.2f", modifier);
+            }
+            changed = true;
+        }
+    }
+    else if (_hud_tile_info.valid) {
+        hud_text_invalidate(&_hud_tile_info);
+        changed = true;
+    }
+    return changed;
 }
 
 // Draw the information panel for a tile
-void draw_hud_tile_info(Vector3 pos, int q, int r) {
-    char buffer[1024] = { 0 };
-    Tile* t = world_get_tile(_game.world, q, r);
-    Vector2 pos2DTest = GetWorldToScreen(Vector3{ 0,0,0 }, _camera3D);
-    Vector2 pos2D = GetWorldToScreen(pos, _camera3D);
-    const float width = 200;
-    const float height = 60;
-    Rectangle rect = { .x = pos2D.x - width / 2, .y = pos2D.y - height * 1.3f,
-                       .width = width, .height = height };
+void draw_hud_tile_info(Vector3 pos) {
+    Rectangle rect = hud_panel_layout(&_hud_tile_panel, pos, _camera3D, 200, 60);
 
     GuiPanel(rect,"Information");
-    int end = 0;
-    TextAppend(buffer, "Goods:\n", &end);
-    TextAppend(buffer, TextFormat("%d", (int)t->supply[0]), &end);
-    for (int i = 1; i < GOOD_COUNT; ++i) {
-        TextAppend(buffer, TextFormat("/%d", (int)t->supply[i]), &end);
-    }
     rect.y += 15; // Panel bar
     GuiSetStyle(TEXTBOX, TEXT_ALIGNMENT_VERTICAL, TEXT_ALIGN_TOP);   // WARNING: Word-wrap does not work as expected in case of no-top alignment
     GuiSetStyle(TEXTBOX, TEXT_WRAP_MODE, TEXT_WRAP_WORD);            // WARNING: If wrap mode enabled, text editing is not supported
     GuiSetStyle(TEXTBOX, BORDER_WIDTH, 0);
-    GuiTextBox(rect, buffer, 12, false);
+    GuiTextBox(rect, _hud_tile_info.text, 12, false);
 }
 
-void draw_tile(int type, int rotation, int q, int r, Color color)
+void draw_tile(int type, int model, int rotation, int q, int r, Color color)
 {
     if (type == -1) return;
-    const Vector3 pos = pointy_hex_to_pixel(q, r, _size) + _origin;
-    DrawModelEx(g_models[_editor_tiles[type*2 + 1]], 
+    Vector3 pos = hex_to_world(Hex{ q, r }, _size) + _origin;
+    if (type == ECONOMY_TILE_ROAD) {
+        render_queue_model(model_manager_get(MODEL_BUILDING_GRASS),
+            pos, Vector3{ 0,1,0 }, 0.0f, Vector3{ 1, 1, 1 }, WHITE);
+        pos.y += _path_height;
+    }
+    render_queue_model(model_manager_get(model),
         pos, Vector3{ 0,1,0 }, 60.0f * rotation, Vector3{ 1, 1, 1 }, WHITE);
 }
 
 void gameplay_screen_draw_hud() {
     BeginMode2D(_camera2D);
 
-    Vector3 gui_pos{ 20,20 };
     const float width = 10.0f;
     const float height = 10.0f;
 
-    GuiPanel(Rectangle{ .x = gui_pos.x, .y = gui_pos.y, .width = 200, .height = 200 }, "Settings");
+    GuiPanel(_settings_bounds, "Settings");
+
+    GuiCheckBox(Rectangle{ .x = 30, .y = 50, .width = width, .height = height }, "Show Info", &_show_info);
+    GuiCheckBox(Rectangle{ .x = 30, .y = 102, .width = width, .height = height }, "Redraw on change", &_on_demand);
+    GuiCheckBox(Rectangle{ .x = 30, .y = 120, .width = width, .height = height }, "Heatmap", &_show_heatmap);
+    GuiComboBox(Rectangle{ .x = 30, .y = 136, .width = 160, .height = 20 },
+        "Wood supply;Wheat supply", &_heatmap_mode);
 
-    static bool show_info = false;
-    GuiCheckBox(Rectangle{ .x = 30, .y = 50, .width = width, .height = height }, "Show Info", &show_info);
+    GuiLabel(Rectangle{ .x = 30, .y = 70, .width = 180, .height = 12 }, _hud_draws.text);
+    GuiLabel(Rectangle{ .x = 30, .y = 84, .width = 180, .height = 12 }, _hud_changes.text);
     
-    const Vector3 pos = pointy_hex_to_pixel(_game.cursor.hex.q, _game.cursor.hex.r, _size) + _origin;
+    const Vector3 pos = hex_to_world(_game.cursor.hex, _size) + _origin;
 
-    if (show_info && _tiles[_game.cursor.hex.q][_game.cursor.hex.r].type != -1) {
-        draw_hud_tile_info(pos, _game.cursor.hex.q, _game.cursor.hex.r);
+    if (_show_info && _tiles[_game.cursor.hex.q][_game.cursor.hex.r].type != -1) {
+        draw_hud_tile_info(pos);
     }
 
+    minimap_draw(minimap_bounds());
+
     EndMode2D();
 }
 
@@ -337,40 +471,79 @@ void draw_gameplay_screen(void)
     //DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), PURPLE);
     BeginMode3D(_camera3D);
     draw_coords(Vector3{ 0,0,0 });
+    render_queue_begin(_camera3D);
     for (int q = 0; q < _board_size; ++q) {
         for (int r = 0; r < _board_size; ++r)
         {
             Tile* t = &_game.world->tiles[q * _game.world->max_r + r];
-            draw_tile(t->type, t->rotation, q, r, WHITE);
+            draw_tile(t->type, t->model_type, t->rotation, q, r, WHITE);
         }
     }
 
+    const Model* character = model_manager_get(MODEL_CHARACTER_FEMALE);
+    int idle = vat_find_clip(&_crowd, "idle");
+    int wave = vat_find_clip(&_crowd, "emote-yes");
     for (int i = 0; i < _game.world->people_count; ++i) {
         Person* p = &_game.world->people[i];
-        Vector3 pos = pointy_hex_to_pixel(p->q, p->r, _size);
-        DrawModel(g_models[p->model_type], _origin + pos + p->tile_pos , .3, WHITE);
+        Vector3 pos = _origin + hex_to_world(Hex{ p->q, p->r }, _size) + p->tile_pos;
+        if (p->model_type == MODEL_CHARACTER_FEMALE && vat_ready(&_crowd)) {
+            // Offsets keep the crowd from moving in lockstep, the selected person waves
+            Matrix transform = MatrixMultiply(character->transform,
+                MatrixMultiply(MatrixScale(.3f, .3f, .3f), MatrixTranslate(pos.x, pos.y, pos.z)));
+            int clip = (p == _game.selected_person && wave != -1) ? wave : idle;
+            vat_queue(&_crowd, transform, (clip == -1) ? 0 : clip, i * 0.37f);
+            continue;
+        }
+        render_queue_model(model_manager_get(p->model_type), pos,
+            Vector3{ 0,1,0 }, 0.0f, Vector3{ .3f, .3f, .3f }, WHITE);
     }
 
-    const Vector3 pos  = pointy_hex_to_pixel(_game.cursor.hex.q, _game.cursor.hex.r, _size) + _origin;
+    const Vector3 pos  = hex_to_world(_game.cursor.hex, _size) + _origin;
 
     if (_tiles[_game.cursor.hex.q][_game.cursor.hex.r].type == -1) {
-        draw_tile(_game.cursor.tile.type, _game.cursor.tile.rotation, 
-            _game.cursor.hex.q, _game.cursor.hex.r, Color(255, 255, 255, 128));
+        // Roads and rivers preview the shape they would get at the cursor
+        int type = _game.cursor.tile.type;
+        int model = _editor_tiles[type*2 + 1];
+        int rotation = _game.cursor.tile.rotation;
+        if (type == ECONOMY_TILE_ROAD || type == ECONOMY_TILE_RIVER) {
+            AutoTile shape = autotile_lookup(world_link_mask(_game.world, type, _game.cursor.hex.q, _game.cursor.hex.r));
+            model += shape.shape;
+            rotation = shape.rotation;
+        }
+        draw_tile(type, model, rotation, _game.cursor.hex.q, _game.cursor.hex.r, Color(255, 255, 255, 128));
     }
     else {
         DrawCubeWires(pos, 1, 1, 1, BLUE);
     }
 
+    {
+        PROFILE_ZONE("render_queue_flush");
+        render_queue_flush();
+    }
+    {
+        PROFILE_ZONE("crowd");
+        vat_flush(&_crowd, character, _crowd_time);
+    }
+    heatmap_draw();
+    _drawn_revision = _game.world->revision;
 
     EndMode3D();
     // Draw the HUB on top of the game screen
+    PROFILE_ZONE("hud");
     gameplay_screen_draw_hud();
 }
 
 // Gameplay Screen Unload logic
 void unload_gameplay_screen(void)
 {
+    world_log_memory(_game.world);
     world_destroy(_game.world);
+    minimap_unload();
+    heatmap_unload();
+    picking_unload();
+    render_queue_unload();
+    vat_unload(&_crowd);
+    _crowd_baked = false;
 }
 
 // Gameplay Screen should finish?
@@ -25,6 +25,8 @@
 
 #include "raylib.h"
 #include "screens.h"
+#include "assets.hpp"
+#include "model_manager.hpp"
 
 //----------------------------------------------------------------------------------
 // Module Variables Definition (local)
@@ -46,6 +48,8 @@ static int rightSideRecHeight = 0;
 static int state = 0;              // Logo animation states
 static float alpha = 1.0f;         // Useful for fading
 
+static bool loaded = false;         // Models needed by gameplay are resident or failed to load
+
 //----------------------------------------------------------------------------------
 // Logo Screen Functions Definition
 //----------------------------------------------------------------------------------
@@ -67,11 +71,34 @@ void init_logo_screen(void)
 
     state = 0;
     alpha = 1.0f;
+
+    loaded = false;
+
+    // Built in models are needed as soon as gameplay starts
+    for (int i = 0; i < MODEL_COUNT; ++i) model_manager_prefetch(i);
 }
 
 // Logo Screen Update logic
 void update_logo_screen(void)
 {
+    if (!loaded)
+    {
+        loaded = true;
+        for (int i = 0; i < MODEL_COUNT; ++i)
+        {
+            model_manager_prefetch(i);
+            // A model that failed is drawn as the placeholder, waiting for it would never end
+            loaded = loaded && model_manager_is_finished(i);
+        }
+    }
+
+    // Once everything is loaded the animation can be skipped
+    if (loaded && (IsKeyPressed(KEY_ENTER) || IsGestureDetected(GESTURE_TAP)))
+    {
+        finishScreen = 1;
+        return;
+    }
+
     if (state == 0)                 // State 0: Top-left square corner blink logic
     {
         framesCounter++;
@@ -110,7 +137,7 @@ void update_logo_screen(void)
         }
         else    // When all letters have appeared, just fade out everything
         {
-            if (framesCounter > 200)
+            if ((framesCounter > 200) && loaded)
             {
                 alpha -= 0.02f;
 
@@ -158,6 +185,12 @@ void draw_logo_screen(void)
 
         if (framesCounter > 20) DrawText("powered by", logoPositionX, logoPositionY - 27, 20, Fade(DARKGRAY, alpha));
     }
+
+    // Draw loading progress bar
+    float progress = loaded? 1.0f : model_manager_progress();
+    DrawRectangle(logoPositionX, logoPositionY + 272, 256, 8, Fade(LIGHTGRAY, alpha));
+    DrawRectangle(logoPositionX, logoPositionY + 272, (int)(256*progress), 8, Fade(BLACK, alpha));
+    if (!loaded) DrawText(TextFormat("Loading %d%%", (int)(100*progress)), logoPositionX, logoPositionY + 286, 10, Fade(DARKGRAY, alpha));
 }
 
 // Logo Screen Unload logic
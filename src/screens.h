@@ -44,8 +44,6 @@ extern Font font;
 extern Music music;
 extern Sound fxCoin;
 
-extern Model *g_models;
-
 #ifdef __cplusplus
 extern "C" {            // Prevents name mangling of functions
 #endif
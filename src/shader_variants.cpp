@@ -0,0 +1,228 @@
+#include "shader_variants.hpp"
+#include "memory.hpp"
+
+#include "rlights.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ShaderVariant {
+    unsigned int key;
+    Shader shader;
+    int light_revision;     // Revision of the lights that were last uploaded
+    int light_locs[SHADER_LIGHTS_MAX][3];
+    int ambient_loc;
+};
+
+static char* _vs_source = nullptr;
+static char* _fs_source = nullptr;
+
+static ShaderVariant _variants[SHADER_VARIANT_MAX] = { 0 };
+static int _variant_count = 0;
+
+static Light _lights[SHADER_LIGHTS_MAX] = { 0 };
+static int _light_count = 0;
+static Vector4 _ambient = { 0.2f, 0.2f, 0.2f, 0.2f };
+static int _light_revision = 1;
+
+void shader_variants_init(const char* vs_filename, const char* fs_filename)
+{
+    if (_vs_source != nullptr) return;
+    _vs_source = LoadFileText(vs_filename);
+    _fs_source = LoadFileText(fs_filename);
+}
+
+void shader_variants_unload()
+{
+    for (int i = 0; i < _variant_count; ++i) {
+        UnloadShader(_variants[i].shader);
+    }
+    _variant_count = 0;
+
+    UnloadFileText(_vs_source);
+    UnloadFileText(_fs_source);
+    _vs_source = nullptr;
+    _fs_source = nullptr;
+}
+
+// The defines have to go after the #version line
+static char* shader_variant_source(const char* source, const char* defines)
+{
+    if (source == nullptr) return nullptr;
+
+    const char* body = source;
+    if (strncmp(source, "#version", 8) == 0) {
+        body = strchr(source, '\n');
+        body = (body == nullptr) ? source + strlen(source) : body + 1;
+    }
+
+    size_t length = strlen(source) + strlen(defines) + 1;
+    char* result = (char*)memory_alloc(MEMORY_TAG_RENDER, length);
+    if (result == nullptr) return nullptr;
+    snprintf(result, length, "%.*s%s%s", (int)(body - source), source, defines, body);
+    return result;
+}
+
+static void shader_variant_upload_lights(ShaderVariant* v)
+{
+    // Directional lights go to the first slots and point lights after them, a variant with more
+    // slots than the scene has lights gets black lights in the remaining ones
+    int counts[2] = { (int)(v->key & 0xf), (int)((v->key >> 4) & 0xf) };
+    int slot = 0;
+    for (int type = LIGHT_DIRECTIONAL; type <= LIGHT_POINT; ++type) {
+        int used = 0;
+        for (int i = 0; i < _light_count && used < counts[type]; ++i) {
+            const Light* light = &_lights[i];
+            if (light->type != type) continue;
+
+            float position[3] = { light->position.x, light->position.y, light->position.z };
+            float target[3] = { light->target.x, light->target.y, light->target.z };
+            float color[4] = { light->color.r/255.0f, light->color.g/255.0f,
+                               light->color.b/255.0f, light->color.a/255.0f };
+            SetShaderValue(v->shader, v->light_locs[slot][0], position, SHADER_UNIFORM_VEC3);
+            SetShaderValue(v->shader, v->light_locs[slot][1], target, SHADER_UNIFORM_VEC3);
+            SetShaderValue(v->shader, v->light_locs[slot][2], color, SHADER_UNIFORM_VEC4);
+            ++slot;
+            ++used;
+        }
+        for (; used < counts[type]; ++used) {
+            float black[4] = { 0 };
+            SetShaderValue(v->shader, v->light_locs[slot][2], black, SHADER_UNIFORM_VEC4);
+            ++slot;
+        }
+    }
+
+    float ambient[4] = { _ambient.x, _ambient.y, _ambient.z, _ambient.w };
+    SetShaderValue(v->shader, v->ambient_loc, ambient, SHADER_UNIFORM_VEC4);
+    v->light_revision = _light_revision;
+}
+
+// Every compiled variant may be bound to a material, so all of them are updated right away
+static void lighting_changed()
+{
+    ++_light_revision;
+    for (int i = 0; i < _variant_count; ++i) {
+        shader_variant_upload_lights(&_variants[i]);
+    }
+}
+
+static ShaderVariant* shader_variant_compile(unsigned int key)
+{
+    if (_variant_count >= SHADER_VARIANT_MAX) {
+        TraceLog(LOG_WARNING, "SHADER: Too many variants, can't compile %x", key);
+        return nullptr;
+    }
+
+    int directional = key & 0xf;
+    int point = (key >> 4) & 0xf;
+    unsigned int features = key >> 8;
+    if (directional + point > SHADER_LIGHTS_MAX) {
+        TraceLog(LOG_WARNING, "SHADER: Variant %x has more than %d lights", key, SHADER_LIGHTS_MAX);
+        return nullptr;
+    }
+    const char* defines = TextFormat("#define DIRECTIONAL_LIGHTS %d\n#define POINT_LIGHTS %d\n#define INSTANCING %d\n#define VERTEX_ANIMATION %d\n",
+        directional, point, (features & SHADER_FEATURE_INSTANCING) ? 1 : 0,
+        (features & SHADER_FEATURE_VERTEX_ANIMATION) ? 1 : 0);
+
+    char* vs = shader_variant_source(_vs_source, defines);
+    char* fs = shader_variant_source(_fs_source, defines);
+    Shader shader = LoadShaderFromMemory(vs, fs);
+    memory_free(vs);
+    memory_free(fs);
+
+    ShaderVariant* v = &_variants[_variant_count++];
+    *v = ShaderVariant{ 0 };
+    v->key = key;
+    v->shader = shader;
+
+    shader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(shader, "viewPos");
+    if (features & SHADER_FEATURE_INSTANCING) {
+        shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
+    }
+    if (features & SHADER_FEATURE_VERTEX_ANIMATION) {
+        // raylib binds material map i to the sampler at locs[SHADER_LOC_MAP_DIFFUSE + i]
+        shader.locs[SHADER_LOC_MAP_DIFFUSE + (int)SHADER_MAP_VAT_POSITIONS] = GetShaderLocation(shader, "vatPositions");
+        shader.locs[SHADER_LOC_MAP_DIFFUSE + (int)SHADER_MAP_VAT_NORMALS] = GetShaderLocation(shader, "vatNormals");
+    }
+    // NOTE: "matModel" location name is automatically assigned on shader loading,
+    // no need to get the location again if using that uniform name
+
+    for (int i = 0; i < SHADER_LIGHTS_MAX; ++i) {
+        v->light_locs[i][0] = -1;
+        v->light_locs[i][1] = -1;
+        v->light_locs[i][2] = -1;
+    }
+    for (int i = 0; i < directional + point && i < SHADER_LIGHTS_MAX; ++i) {
+        v->light_locs[i][0] = GetShaderLocation(shader, TextFormat("lights[%i].position", i));
+        v->light_locs[i][1] = GetShaderLocation(shader, TextFormat("lights[%i].target", i));
+        v->light_locs[i][2] = GetShaderLocation(shader, TextFormat("lights[%i].color", i));
+    }
+    v->ambient_loc = GetShaderLocation(shader, "ambient");
+
+    TraceLog(LOG_INFO, "SHADER: Compiled lighting variant %d directional, %d point, features %x",
+        directional, point, features);
+    return v;
+}
+
+Shader shader_variant_get(unsigned int key)
+{
+    ShaderVariant* v = nullptr;
+    for (int i = 0; i < _variant_count; ++i) {
+        if (_variants[i].key == key) {
+            v = &_variants[i];
+            break;
+        }
+    }
+    if (v == nullptr) v = shader_variant_compile(key);
+    if (v == nullptr) return Shader{ 0 };
+
+    if (v->light_revision != _light_revision) shader_variant_upload_lights(v);
+    return v->shader;
+}
+
+int shader_variant_count()
+{
+    return _variant_count;
+}
+
+int lighting_add(int type, Vector3 position, Vector3 target, Color color)
+{
+    if (_light_count >= SHADER_LIGHTS_MAX) {
+        TraceLog(LOG_WARNING, "SHADER: Too many lights (%d)", SHADER_LIGHTS_MAX);
+        return -1;
+    }
+    Light* light = &_lights[_light_count];
+    *light = Light{ 0 };
+    light->type = type;
+    light->enabled = true;
+    light->position = position;
+    light->target = target;
+    light->color = color;
+    ++_light_count;
+    lighting_changed();
+    return _light_count - 1;
+}
+
+void lighting_clear()
+{
+    _light_count = 0;
+    lighting_changed();
+}
+
+void lighting_set_ambient(Vector4 ambient)
+{
+    _ambient = ambient;
+    lighting_changed();
+}
+
+unsigned int lighting_key(unsigned int features)
+{
+    int directional = 0;
+    int point = 0;
+    for (int i = 0; i < _light_count; ++i) {
+        if (_lights[i].type == LIGHT_DIRECTIONAL) ++directional;
+        else if (_lights[i].type == LIGHT_POINT) ++point;
+    }
+    return shader_variant_key(directional, point, features);
+}
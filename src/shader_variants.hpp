@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+Shader variants, the lighting shader is compiled from the same source with different #defines for the
+number of lights of each type and optional features. Compiled programs are cached by their key so each
+draw can use the smallest variant that covers the lights in the scene, a scene with one directional
+light doesn't pay for the lights it doesn't have.
+*/
+
+#include "raylib.h"
+
+#define SHADER_VARIANT_MAX 32
+#define SHADER_LIGHTS_MAX 4
+
+// Optional features, part of the variant key
+enum ShaderFeature {
+    SHADER_FEATURE_NONE = 0,
+    SHADER_FEATURE_INSTANCING = 1 << 0,
+    SHADER_FEATURE_VERTEX_ANIMATION = 1 << 1,   // Needs SHADER_FEATURE_INSTANCING
+};
+
+// Material maps that carry the vertex animation textures in the VERTEX_ANIMATION variants
+#define SHADER_MAP_VAT_POSITIONS MATERIAL_MAP_METALNESS
+#define SHADER_MAP_VAT_NORMALS MATERIAL_MAP_NORMAL
+
+// Key layout: bits 0-3 directional lights, bits 4-7 point lights, bits 8+ features
+constexpr unsigned int shader_variant_key(int directional, int point, unsigned int features)
+{
+    return (unsigned int)directional | ((unsigned int)point << 4) | (features << 8);
+}
+
+void shader_variants_init(const char* vs_filename, const char* fs_filename);
+void shader_variants_unload();
+
+// Returns the program for key, compiling it on first use
+Shader shader_variant_get(unsigned int key);
+
+int shader_variant_count();
+
+// Scene lights, every compiled variant is kept up to date with them
+int lighting_add(int type, Vector3 position, Vector3 target, Color color);
+void lighting_clear();
+void lighting_set_ambient(Vector4 ambient);
+
+// Key of the smallest variant that fits the current lights
+unsigned int lighting_key(unsigned int features);
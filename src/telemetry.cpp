@@ -0,0 +1,215 @@
+#include "telemetry.hpp"
+
+#include "raylib.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct Metric {
+    char name[TELEMETRY_NAME_LENGTH];
+    const char* help;
+    int kind;
+    std::atomic<int64_t> count;     // Counters
+    std::atomic<double> value;      // Gauges
+};
+
+static Metric _metrics[TELEMETRY_METRICS_MAX];
+static std::atomic<int> _metric_count = 0;
+static std::mutex _registry_mutex;
+
+static char _path[256] = { 0 };
+static int _format = TELEMETRY_CSV;
+static double _interval = 5.0;
+static size_t _max_bytes = 0;
+static int _keep = 0;
+static int _header_count = -1;     // Metrics in the header of the current CSV file, -1 before one is written
+
+static std::mutex _flush_mutex;    // Serializes writes of the thread and telemetry_flush
+static std::mutex _thread_mutex;
+static std::condition_variable _wakeup;
+static bool _stopping = false;
+static std::thread _thread;
+
+static MetricId telemetry_register(const char* name, const char* help, int kind)
+{
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    int count = _metric_count.load();
+    for (int i = 0; i < count; ++i) {
+        if (strcmp(_metrics[i].name, name) == 0) return i;
+    }
+    if (count >= TELEMETRY_METRICS_MAX) {
+        TraceLog(LOG_WARNING, "TELEMETRY: Too many metrics, can't register %s", name);
+        return METRIC_INVALID;
+    }
+
+    Metric* metric = &_metrics[count];
+    snprintf(metric->name, sizeof(metric->name), "%s", name);
+    metric->help = help;
+    metric->kind = kind;
+    metric->count.store(0);
+    metric->value.store(0.0);
+    _metric_count.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+MetricId telemetry_counter(const char* name, const char* help)
+{
+    return telemetry_register(name, help, METRIC_COUNTER);
+}
+
+MetricId telemetry_gauge(const char* name, const char* help)
+{
+    return telemetry_register(name, help, METRIC_GAUGE);
+}
+
+void telemetry_add(MetricId id, int64_t value)
+{
+    if (id < 0 || id >= TELEMETRY_METRICS_MAX) return;
+    _metrics[id].count.fetch_add(value, std::memory_order_relaxed);
+}
+
+void telemetry_set(MetricId id, double value)
+{
+    if (id < 0 || id >= TELEMETRY_METRICS_MAX) return;
+    _metrics[id].value.store(value, std::memory_order_relaxed);
+}
+
+// path -> path.1 -> path.2 ..., the oldest one is dropped
+static void telemetry_rotate()
+{
+    char from[300];
+    char to[300];
+    snprintf(to, sizeof(to), "%s.%d", _path, _keep);
+    remove(to);
+    for (int i = _keep - 1; i >= 1; --i) {
+        snprintf(from, sizeof(from), "%s.%d", _path, i);
+        snprintf(to, sizeof(to), "%s.%d", _path, i + 1);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", _path);
+    if (_keep > 0) rename(_path, to);
+    else remove(_path);
+}
+
+static bool telemetry_write_csv(int count)
+{
+    // New metrics change the columns, that starts a new file as well
+    FILE* file = fopen(_path, "ab");
+    if (file == nullptr) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    if ((_max_bytes > 0 && (size_t)size >= _max_bytes) || (size > 0 && _header_count != count)) {
+        fclose(file);
+        telemetry_rotate();
+        file = fopen(_path, "wb");
+        if (file == nullptr) return false;
+        size = 0;
+    }
+
+    if (size == 0) {
+        fputs("time", file);
+        for (int i = 0; i < count; ++i) {
+            fprintf(file, ",%s%s", _metrics[i].name, (_metrics[i].kind == METRIC_COUNTER) ? "_total" : "");
+        }
+        fputc('\n', file);
+        _header_count = count;
+    }
+
+    fprintf(file, "%lld", (long long)time(nullptr));
+    for (int i = 0; i < count; ++i) {
+        if (_metrics[i].kind == METRIC_COUNTER) fprintf(file, ",%lld", (long long)_metrics[i].count.load(std::memory_order_relaxed));
+        else fprintf(file, ",%g", _metrics[i].value.load(std::memory_order_relaxed));
+    }
+    fputc('\n', file);
+    fclose(file);
+    return true;
+}
+
+// Written next to the target and renamed over it, a scraper never sees half a file
+static bool telemetry_write_openmetrics(int count)
+{
+    char temp[300];
+    snprintf(temp, sizeof(temp), "%s.tmp", _path);
+    FILE* file = fopen(temp, "wb");
+    if (file == nullptr) return false;
+
+    for (int i = 0; i < count; ++i) {
+        const Metric* metric = &_metrics[i];
+        bool counter = metric->kind == METRIC_COUNTER;
+        fprintf(file, "# TYPE %s %s\n", metric->name, counter ? "counter" : "gauge");
+        if (metric->help != nullptr) fprintf(file, "# HELP %s %s\n", metric->name, metric->help);
+        if (counter) fprintf(file, "%s_total %lld\n", metric->name, (long long)metric->count.load(std::memory_order_relaxed));
+        else fprintf(file, "%s %g\n", metric->name, metric->value.load(std::memory_order_relaxed));
+    }
+    fputs("# EOF\n", file);
+    fclose(file);
+
+    remove(_path);
+    return rename(temp, _path) == 0;
+}
+
+bool telemetry_flush()
+{
+    std::lock_guard<std::mutex> lock(_flush_mutex);
+    if (_path[0] == '\0') return false;
+
+    int count = _metric_count.load(std::memory_order_acquire);
+    bool ok = (_format == TELEMETRY_OPENMETRICS) ? telemetry_write_openmetrics(count) : telemetry_write_csv(count);
+    if (!ok) TraceLog(LOG_WARNING, "TELEMETRY: Can't write %s", _path);
+    return ok;
+}
+
+#if !defined(PLATFORM_WEB)
+static void telemetry_thread()
+{
+    std::unique_lock<std::mutex> lock(_thread_mutex);
+    while (!_stopping) {
+        _wakeup.wait_for(lock, std::chrono::duration<double>(_interval), [] { return _stopping; });
+        if (_stopping) break;
+        lock.unlock();
+        telemetry_flush();
+        lock.lock();
+    }
+}
+#endif
+
+void telemetry_start(const char* path, int format, double interval, size_t max_bytes, int keep)
+{
+#if defined(PLATFORM_WEB)
+    TraceLog(LOG_INFO, "TELEMETRY: Not available on the web");
+#else
+    if (_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(_flush_mutex);
+        snprintf(_path, sizeof(_path), "%s", path);
+        _format = format;
+        _interval = (interval > 0) ? interval : 1.0;
+        _max_bytes = max_bytes;
+        _keep = keep;
+        _header_count = -1;
+    }
+    _stopping = false;
+    _thread = std::thread(telemetry_thread);
+    TraceLog(LOG_INFO, "TELEMETRY: Writing to %s every %.1fs", path, _interval);
+#endif
+}
+
+void telemetry_stop()
+{
+    if (!_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(_thread_mutex);
+        _stopping = true;
+    }
+    _wakeup.notify_all();
+    _thread.join();
+    telemetry_flush();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+Simulation telemetry, a registry of named counters and gauges. Updating a metric is a single relaxed
+atomic operation so it can be done from any thread and in hot loops, although batching per tick is
+cheaper still. A background thread takes a snapshot every interval and writes it either as a row of a
+CSV file that is rotated once it grows too big, or as an OpenMetrics text file that is replaced on
+every flush, ready to be scraped.
+
+On the web there are no threads, telemetry_start does nothing there.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_METRICS_MAX 64
+#define TELEMETRY_NAME_LENGTH 64
+
+typedef int MetricId;
+#define METRIC_INVALID -1
+
+enum MetricKind {
+    METRIC_COUNTER,         // Only goes up, written as <name>_total
+    METRIC_GAUGE,
+};
+
+enum TelemetryFormat {
+    TELEMETRY_CSV,
+    TELEMETRY_OPENMETRICS,
+};
+
+// Registering a name twice returns the same id, names should follow the prometheus conventions
+MetricId telemetry_counter(const char* name, const char* help);
+MetricId telemetry_gauge(const char* name, const char* help);
+
+void telemetry_add(MetricId id, int64_t value);
+void telemetry_set(MetricId id, double value);
+
+// Starts flushing to path every interval seconds. CSV files are rotated to path.1 .. path.<keep>
+// when they grow past max_bytes
+void telemetry_start(const char* path, int format, double interval, size_t max_bytes, int keep);
+
+// Writes a last snapshot and stops the thread
+void telemetry_stop();
+
+// Writes a snapshot right away, returns false if the file couldn't be written
+bool telemetry_flush();
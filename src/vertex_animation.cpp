@@ -0,0 +1,244 @@
+#include "vertex_animation.hpp"
+#include "memory.hpp"
+#include "shader_variants.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// raylib samples gltf animations every 17ms
+#define VAT_SOURCE_FPS (1000.0f / 17.0f)
+
+// Vertex buffer indices used by raylib for a mesh
+#define VAT_BUFFER_POSITIONS 0
+#define VAT_BUFFER_NORMALS 2
+
+static bool vat_clip_wanted(const char* name, const char** clip_names, int clip_count)
+{
+    if (clip_names == nullptr) return true;
+    for (int i = 0; i < clip_count; ++i) {
+        if (strcmp(name, clip_names[i]) == 0) return true;
+    }
+    return false;
+}
+
+static Texture2D vat_upload(float* data, int width, int height)
+{
+    Image image = { 0 };
+    image.data = data;
+    image.width = width;
+    image.height = height;
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R32G32B32;
+    Texture2D texture = LoadTextureFromImage(image);
+    SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+    return texture;
+}
+
+bool vat_bake(VertexAnimation* vat, const Model* model, const char* filename, const char** clip_names, int clip_count)
+{
+    *vat = VertexAnimation{ 0 };
+    if (model == nullptr || model->meshCount > VAT_MAX_MESHES) {
+        TraceLog(LOG_WARNING, "VAT: Can't bake %s, model has too many meshes", filename);
+        return false;
+    }
+
+    int anim_count = 0;
+    ModelAnimation* anims = LoadModelAnimations(filename, &anim_count);
+    if (anims == nullptr) {
+        TraceLog(LOG_WARNING, "VAT: No animations in %s", filename);
+        return false;
+    }
+
+    // Pick the clips and lay them out one after the other
+    int sources[VAT_MAX_CLIPS] = { 0 };
+    for (int i = 0; i < anim_count; ++i) {
+        if (!vat_clip_wanted(anims[i].name, clip_names, clip_count)) continue;
+        if (!IsModelAnimationValid(*model, anims[i])) {
+            TraceLog(LOG_WARNING, "VAT: Clip %s doesn't match the model of %s", anims[i].name, filename);
+            continue;
+        }
+        if (vat->clip_count >= VAT_MAX_CLIPS) {
+            TraceLog(LOG_WARNING, "VAT: More than %d clips in %s", VAT_MAX_CLIPS, filename);
+            break;
+        }
+        VatClip* clip = &vat->clips[vat->clip_count];
+        strncpy(clip->name, anims[i].name, sizeof(clip->name) - 1);
+        clip->first_frame = vat->frame_count;
+        clip->frame_count = (int)ceilf(anims[i].frameCount * VAT_BAKE_FPS / VAT_SOURCE_FPS);
+        if (clip->frame_count < 1) clip->frame_count = 1;
+        vat->frame_count += clip->frame_count;
+        sources[vat->clip_count++] = i;
+    }
+
+    float* positions[VAT_MAX_MESHES] = { 0 };
+    float* normals[VAT_MAX_MESHES] = { 0 };
+    bool ok = vat->clip_count > 0;
+    vat->mesh_count = model->meshCount;
+    for (int m = 0; ok && m < model->meshCount; ++m) {
+        VatMesh* mesh = &vat->meshes[m];
+        mesh->vertex_count = model->meshes[m].vertexCount;
+        mesh->width = (mesh->vertex_count < VAT_MAX_TEXTURE_SIZE) ? mesh->vertex_count : VAT_MAX_TEXTURE_SIZE;
+        mesh->rows_per_frame = (mesh->vertex_count + mesh->width - 1) / mesh->width;
+        if (mesh->rows_per_frame * vat->frame_count > VAT_MAX_TEXTURE_SIZE) {
+            TraceLog(LOG_WARNING, "VAT: %d frames of mesh %d don't fit into a texture", vat->frame_count, m);
+            ok = false;
+            break;
+        }
+        size_t floats = (size_t)mesh->width * mesh->rows_per_frame * vat->frame_count * 3;
+        positions[m] = (float*)memory_calloc(MEMORY_TAG_RENDER, floats, sizeof(float));
+        normals[m] = (float*)memory_calloc(MEMORY_TAG_RENDER, floats, sizeof(float));
+        if (positions[m] == nullptr || normals[m] == nullptr) ok = false;
+    }
+
+    // Skin every baked frame on the cpu and copy the result into its rows
+    for (int c = 0; ok && c < vat->clip_count; ++c) {
+        const VatClip* clip = &vat->clips[c];
+        ModelAnimation anim = anims[sources[c]];
+        for (int f = 0; f < clip->frame_count; ++f) {
+            int source = (int)roundf(f * VAT_SOURCE_FPS / VAT_BAKE_FPS);
+            if (source >= anim.frameCount) source = anim.frameCount - 1;
+            UpdateModelAnimation(*model, anim, source);
+
+            for (int m = 0; m < model->meshCount; ++m) {
+                const Mesh* mesh = &model->meshes[m];
+                const VatMesh* baked = &vat->meshes[m];
+                size_t offset = (size_t)(clip->first_frame + f) * baked->width * baked->rows_per_frame * 3;
+                size_t bytes = (size_t)mesh->vertexCount * 3 * sizeof(float);
+                const float* v = (mesh->animVertices != nullptr) ? mesh->animVertices : mesh->vertices;
+                const float* n = (mesh->animNormals != nullptr) ? mesh->animNormals : mesh->normals;
+                memcpy(positions[m] + offset, v, bytes);
+                if (n != nullptr) memcpy(normals[m] + offset, n, bytes);
+            }
+        }
+    }
+
+    for (int m = 0; m < model->meshCount; ++m) {
+        Mesh mesh = model->meshes[m];
+        VatMesh* baked = &vat->meshes[m];
+        if (ok) {
+            int height = baked->rows_per_frame * vat->frame_count;
+            baked->positions = vat_upload(positions[m], baked->width, height);
+            baked->normals = vat_upload(normals[m], baked->width, height);
+            ok = baked->positions.id != 0 && baked->normals.id != 0;
+        }
+        memory_free(positions[m]);
+        memory_free(normals[m]);
+
+        // UpdateModelAnimation wrote the last pose into the gpu buffers, the static model is still drawn from them
+        int bytes = mesh.vertexCount * 3 * sizeof(float);
+        UpdateMeshBuffer(mesh, VAT_BUFFER_POSITIONS, mesh.vertices, bytes, 0);
+        if (mesh.normals != nullptr) UpdateMeshBuffer(mesh, VAT_BUFFER_NORMALS, mesh.normals, bytes, 0);
+
+        baked->maps = (MaterialMap*)memory_calloc(MEMORY_TAG_RENDER, MAX_MATERIAL_MAPS, sizeof(MaterialMap));
+        if (baked->maps == nullptr) {
+            ok = false;
+            continue;
+        }
+        baked->maps[SHADER_MAP_VAT_POSITIONS].texture = baked->positions;
+        baked->maps[SHADER_MAP_VAT_NORMALS].texture = baked->normals;
+    }
+    UnloadModelAnimations(anims, anim_count);
+
+    if (!ok) {
+        TraceLog(LOG_WARNING, "VAT: Failed to bake %s", filename);
+        vat_unload(vat);
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "VAT: Baked %d clips, %d frames of %s", vat->clip_count, vat->frame_count, filename);
+    return true;
+}
+
+void vat_unload(VertexAnimation* vat)
+{
+    for (int m = 0; m < vat->mesh_count; ++m) {
+        VatMesh* mesh = &vat->meshes[m];
+        if (mesh->positions.id != 0) UnloadTexture(mesh->positions);
+        if (mesh->normals.id != 0) UnloadTexture(mesh->normals);
+        memory_free(mesh->maps);
+    }
+    memory_free(vat->instances);
+    *vat = VertexAnimation{ 0 };
+}
+
+bool vat_ready(const VertexAnimation* vat)
+{
+    return vat->clip_count > 0 && vat->mesh_count > 0 && vat->meshes[0].positions.id != 0;
+}
+
+int vat_find_clip(const VertexAnimation* vat, const char* name)
+{
+    for (int i = 0; i < vat->clip_count; ++i) {
+        if (strcmp(vat->clips[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+float vat_clip_length(const VertexAnimation* vat, int clip)
+{
+    if (clip < 0 || clip >= vat->clip_count) return 0.0f;
+    return vat->clips[clip].frame_count / VAT_BAKE_FPS;
+}
+
+void vat_queue(VertexAnimation* vat, Matrix transform, int clip, float time_offset)
+{
+    if (vat->instance_count >= vat->instance_capacity) {
+        int capacity = (vat->instance_capacity == 0) ? 64 : vat->instance_capacity * 2;
+        Matrix* instances = (Matrix*)memory_realloc(MEMORY_TAG_RENDER, vat->instances, capacity * sizeof(Matrix));
+        if (instances == nullptr) return;
+        vat->instances = instances;
+        vat->instance_capacity = capacity;
+    }
+
+    // Affine transforms leave the bottom row unused, the shader restores it to 0,0,0,1
+    transform.m3 = (float)clip;
+    transform.m7 = time_offset;
+    vat->instances[vat->instance_count++] = transform;
+}
+
+void vat_flush(VertexAnimation* vat, const Model* model, float time)
+{
+    int count = vat->instance_count;
+    vat->instance_count = 0;
+
+    // A placeholder is drawn while the model is evicted, its meshes don't match the baked ones
+    if (count == 0 || model == nullptr || !vat_ready(vat) || model->meshCount != vat->mesh_count) return;
+
+    Shader shader = shader_variant_get(lighting_key(SHADER_FEATURE_INSTANCING | SHADER_FEATURE_VERTEX_ANIMATION));
+    if (shader.id == 0) return;
+
+    float clips[VAT_MAX_CLIPS * 2] = { 0 };
+    for (int i = 0; i < vat->clip_count; ++i) {
+        clips[i*2 + 0] = (float)vat->clips[i].first_frame;
+        clips[i*2 + 1] = (float)vat->clips[i].frame_count;
+    }
+    SetShaderValueV(shader, GetShaderLocation(shader, "vatClips"), clips, SHADER_UNIFORM_VEC2, vat->clip_count);
+    int layout_loc = GetShaderLocation(shader, "vatLayout");
+
+    for (int m = 0; m < vat->mesh_count; ++m) {
+        VatMesh* baked = &vat->meshes[m];
+        if (model->meshes[m].vertexCount != baked->vertex_count) continue;
+
+        float layout[4] = { (float)baked->width, (float)baked->rows_per_frame, time, VAT_BAKE_FPS };
+        SetShaderValue(shader, layout_loc, layout, SHADER_UNIFORM_VEC4);
+
+        // The model's own textures may have been reloaded since the bake
+        const Material* source = &model->materials[model->meshMaterial[m]];
+        baked->maps[MATERIAL_MAP_DIFFUSE] = source->maps[MATERIAL_MAP_DIFFUSE];
+
+        Material material = *source;
+        material.shader = shader;
+        material.maps = baked->maps;
+        DrawMeshInstanced(model->meshes[m], material, vat->instances, count);
+    }
+}
+
+bool vat_supported()
+{
+#if defined(PLATFORM_WEB)
+    return false;
+#else
+    return true;
+#endif
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+Vertex animation textures, skeletal animation clips are skinned once at load time and the resulting
+vertex positions and normals are stored in float textures, one row block per frame. Animated models
+are then drawn instanced, the vertex shader looks up its vertex in the texture, so a crowd costs the
+same as the static model no matter how many bones or clips it has.
+
+Every instance picks its own clip and time offset, both travel in the otherwise unused bottom row of
+the instance transform.
+*/
+
+#include "raylib.h"
+
+#define VAT_MAX_MESHES 4
+#define VAT_MAX_CLIPS 32        // Has to match the size of vatClips in lighting.vs
+#define VAT_MAX_TEXTURE_SIZE 4096   // Meshes with more vertices wrap to several rows per frame
+#define VAT_BAKE_FPS 30.0f
+
+struct VatClip {
+    char name[32];
+    int first_frame;
+    int frame_count;
+};
+
+struct VatMesh {
+    Texture2D positions;
+    Texture2D normals;
+    int vertex_count;
+    int width;
+    int rows_per_frame;
+    MaterialMap* maps;          // Material maps for drawing, the textures above are bound in them
+};
+
+struct VertexAnimation {
+    int mesh_count;
+    VatMesh meshes[VAT_MAX_MESHES];
+    int clip_count;
+    VatClip clips[VAT_MAX_CLIPS];
+    int frame_count;            // Baked frames over all clips
+
+    Matrix* instances;          // Transforms with clip and time offset packed into the bottom row
+    int instance_count;
+    int instance_capacity;
+};
+
+// Bakes the named clips of filename for model, clip_names == nullptr bakes every clip in the file.
+// The model has to be uploaded, its gpu buffers are restored to the bind pose afterwards
+bool vat_bake(VertexAnimation* vat, const Model* model, const char* filename, const char** clip_names, int clip_count);
+void vat_unload(VertexAnimation* vat);
+
+bool vat_ready(const VertexAnimation* vat);
+
+// Returns the index of the clip called name or -1
+int vat_find_clip(const VertexAnimation* vat, const char* name);
+
+// Length of a clip in seconds
+float vat_clip_length(const VertexAnimation* vat, int clip);
+
+// Collects an instance for the next vat_flush, transform is the full model transform as for DrawMesh
+void vat_queue(VertexAnimation* vat, Matrix transform, int clip, float time_offset);
+
+// Draws all queued instances of model at time (in seconds), has to be called inside BeginMode3D
+void vat_flush(VertexAnimation* vat, const Model* model, float time);
+
+// Vertex animation needs instancing and vertex texture fetch, not available on every platform
+bool vat_supported();
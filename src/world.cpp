@@ -2,26 +2,125 @@
 
 #include "world.hpp"
 #include "assets.hpp"
+#include "autotile.hpp"
+#include "hex.hpp"
+#include "format.hpp"
+#include "telemetry.hpp"
 
-#include <stdlib.h>
+static const char* _arena_names[WORLD_ARENA_COUNT] = { "tiles", "changes", "layers", "stocks", "scratch" };
+
+static_assert(GOOD_COUNT < 16, "Tile::stock_count has 4 bits");
+static_assert(ECONOMY_TILE_COUNT <= 8 && MODEL_COUNT <= 128, "Tile::type and Tile::model_type are too small");
+
+// The goods each tile type works with, production and demand are per sec
+struct TileRecipe {
+    int type;
+    int good;
+    Quantity production;
+    Quantity demand;
+    Quantity supply_max;
+};
+
+static constexpr TileRecipe _recipes[] = {
+    { ECONOMY_TILE_FARM, GOOD_WHEAT, quantity_from_int(1), 0, quantity_from_int(100) },
+    { ECONOMY_TILE_FOREST, GOOD_WOOD, quantity_from_int(1), 0, quantity_from_int(100) },
+};
+
+static constexpr int recipe_goods(int type)
+{
+    int count = 0;
+    for (const TileRecipe& recipe : _recipes) count += (recipe.type == type) ? 1 : 0;
+    return count;
+}
+
+static constexpr int recipe_goods_max()
+{
+    int most = 0;
+    for (int type = 0; type < ECONOMY_TILE_COUNT; ++type) most = (recipe_goods(type) > most) ? recipe_goods(type) : most;
+    return most;
+}
+
+// No tile has more stocks than this, the pool is sized for every tile having this many
+static constexpr int STOCKS_PER_TILE = recipe_goods_max();
+
+// Carves the arrays out of the sub-arenas, they have to be empty
+static void world_setup(World* w)
+{
+    w->tiles = ARENA_ALLOC(&w->arenas[WORLD_ARENA_TILES], Tile, w->tile_count);
+    w->changes = ARENA_ALLOC(&w->arenas[WORLD_ARENA_CHANGES], int, w->tile_count);
+    w->changed = ARENA_ALLOC(&w->arenas[WORLD_ARENA_CHANGES], unsigned char, w->tile_count);
+    for (int i = 0; i < w->tile_count; ++i) {
+        w->tiles[i].type = ECONOMY_TILE_NONE;
+    }
+    for (int i = 0; i < ECONOMY_TILE_COUNT; ++i) {
+        bitboard_init_arena(&w->layers[i], w->max_q, w->max_r, &w->arenas[WORLD_ARENA_LAYERS]);
+    }
+    w->stock_capacity = w->tile_count * STOCKS_PER_TILE;
+    w->stocks = ARENA_ALLOC(&w->arenas[WORLD_ARENA_STOCKS], Stock, w->stock_capacity);
+    w->stock_info = ARENA_ALLOC(&w->arenas[WORLD_ARENA_STOCKS], StockInfo, w->stock_capacity);
+    w->stock_used = 0;
+    for (int i = 0; i <= GOOD_COUNT; ++i) w->stock_free[i] = -1;
+}
 
 World* world_create(int board_max_q, int board_max_r) 
 {
-    World *w = (World*)calloc(1, sizeof(World));
-    if (w == nullptr) return w;
+    size_t tiles = (size_t)board_max_q * board_max_r;
+    size_t sizes[WORLD_ARENA_COUNT] = {
+        arena_size(tiles * sizeof(Tile)),
+        arena_size(tiles * sizeof(int)) + arena_size(tiles * sizeof(unsigned char)),
+        ECONOMY_TILE_COUNT * arena_size(bitboard_size(board_max_q, board_max_r)),
+        arena_size(tiles * STOCKS_PER_TILE * sizeof(Stock)) + arena_size(tiles * STOCKS_PER_TILE * sizeof(StockInfo)),
+        BITBOARD_COMPONENTS_BOARDS * arena_size(bitboard_size(board_max_q, board_max_r)),
+    };
+    size_t total = arena_size(sizeof(World));
+    for (int i = 0; i < WORLD_ARENA_COUNT; ++i) total += arena_size(sizes[i]);
+
+    Arena memory = { 0 };
+    if (!arena_init(&memory, "world", total, MEMORY_TAG_WORLD)) return nullptr;
+    World *w = ARENA_ALLOC(&memory, World, 1);
+    w->memory = memory;
+    for (int i = 0; i < WORLD_ARENA_COUNT; ++i) {
+        arena_init_sub(&w->arenas[i], _arena_names[i], &w->memory, sizes[i]);
+    }
     w->max_q = board_max_q;
     w->max_r = board_max_r;
     w->tile_count = board_max_q * board_max_r;
-    w->tiles = (Tile*)calloc(board_max_q * board_max_r, sizeof(Tile));
-    for (int i = 0; i < w->tile_count; ++i) {
-        w->tiles[i].type = ECONOMY_TILE_NONE;
-    }
+    world_setup(w);
     return w;
 }
 
 void world_destroy(World* world) {
-    free(world->tiles);
-    free(world);
+    // The arena is part of the block it frees
+    Arena memory = world->memory;
+    arena_free(&memory);
+}
+
+void world_reset(World* world)
+{
+    for (int i = 0; i < WORLD_ARENA_COUNT; ++i) {
+        arena_reset(&world->arenas[i]);
+    }
+    world_setup(world);
+    world->people_count = 0;
+    world->change_count = 0;
+    world->tick = 0;
+    ++world->revision;
+}
+
+size_t world_footprint(const World* world)
+{
+    return world->memory.capacity;
+}
+
+void world_log_memory(const World* world)
+{
+    TraceLog(LOG_INFO, "WORLD: %zu bytes, %d of %d stocks used", world_footprint(world), world->stock_used,
+        world->stock_capacity);
+    for (int i = 0; i < WORLD_ARENA_COUNT; ++i) {
+        const Arena* arena = &world->arenas[i];
+        TraceLog(LOG_INFO, "WORLD: %-8s %10zu of %10zu bytes used, peak %10zu", arena->name, arena->used,
+            arena->capacity, arena->high_water);
+    }
 }
 
 Tile* world_get_tile(World* w, int q, int r) {
@@ -32,6 +131,132 @@ Tile* world_get_tile(World* w, int q, int r) {
     else return &w->tiles[q * w->max_r + r];
 }
 
+int world_find_stock(const World* world, const Tile* tile, int good)
+{
+    for (int i = tile->stock; i < tile->stock + (int)tile->stock_count; ++i) {
+        if (world->stocks[i].good == good) return i;
+    }
+    return -1;
+}
+
+// Takes a block of count entries for the tile at index, from the free list of that size if there is one
+static int world_alloc_stock(World* world, int index, int count)
+{
+    int first = world->stock_free[count];
+    if (first >= 0) {
+        world->stock_free[count] = world->stocks[first].tile;
+    }
+    else if (world->stock_used + count <= world->stock_capacity) {
+        first = world->stock_used;
+        world->stock_used += count;
+    }
+    else {
+        TraceLog(LOG_WARNING, "WORLD: Out of stocks, %d of %d used", world->stock_used, world->stock_capacity);
+        return -1;
+    }
+
+    for (int i = first; i < first + count; ++i) {
+        world->stocks[i] = Stock{ .tile = index, .good = GOOD_NONE, .count = (unsigned char)count };
+        world->stock_info[i] = StockInfo{ .production_modifier = QUANTITY_ONE, .demand_modifier = QUANTITY_ONE };
+    }
+    return first;
+}
+
+static void world_free_stock(World* world, Tile* t)
+{
+    int count = t->stock_count;
+    if (count == 0) return;
+    for (int i = t->stock; i < t->stock + count; ++i) world->stocks[i].good = GOOD_NONE;
+    world->stocks[t->stock].tile = world->stock_free[count];
+    world->stock_free[count] = t->stock;
+    t->stock = 0;
+    t->stock_count = 0;
+}
+
+static void world_mark_changed(World* world, int index)
+{
+    if (world->changed[index]) return;
+    world->changed[index] = 1;
+    world->changes[world->change_count++] = index;
+}
+
+void world_clear_changes(World* world)
+{
+    for (int i = 0; i < world->change_count; ++i) {
+        world->changed[world->changes[i]] = 0;
+    }
+    world->change_count = 0;
+}
+
+// Tiles of type get production and demand scaled by 1 + factor for every tile of neighbor_type
+// within radius. The factors are fixed point so the modifiers come out the same everywhere
+struct AdjacencyRule {
+    int type;
+    int neighbor_type;
+    int radius;
+    Quantity production;
+    Quantity demand;
+};
+
+static constexpr AdjacencyRule _adjacency_rules[] = {
+    { ECONOMY_TILE_FARM, ECONOMY_TILE_RIVER, 1, quantity_from_float(0.25f), 0 },     // Irrigated fields
+    { ECONOMY_TILE_FOREST, ECONOMY_TILE_FOREST, 1, quantity_from_float(0.05f), 0 },  // Woods seed each other
+    { ECONOMY_TILE_FARM, ECONOMY_TILE_HOUSE, 2, quantity_from_float(0.1f), 0 },      // Farmhands close by
+};
+
+static constexpr int adjacency_radius()
+{
+    int radius = 0;
+    for (const AdjacencyRule& rule : _adjacency_rules) radius = (rule.radius > radius) ? rule.radius : radius;
+    return radius;
+}
+
+// A change can only affect tiles this far away
+static constexpr int ADJACENCY_RADIUS = adjacency_radius();
+
+static void world_update_rates(World* world, Hex hex)
+{
+    Tile* t = &world->tiles[hex.q * world->max_r + hex.r];
+    if (t->stock_count == 0) return;
+
+    Quantity production = QUANTITY_ONE;
+    Quantity demand = QUANTITY_ONE;
+    for (const AdjacencyRule& rule : _adjacency_rules) {
+        if (rule.type != t->type) continue;
+
+        Hex area[hex_spiral_count(ADJACENCY_RADIUS)];
+        int count = hex_spiral(hex, rule.radius, area, hex_spiral_count(ADJACENCY_RADIUS));
+        int neighbors = 0;
+        for (int i = 1; i < count; ++i) {
+            if (bitboard_get(&world->layers[rule.neighbor_type], area[i].q, area[i].r)) ++neighbors;
+        }
+        production = quantity_add(production, quantity_mul(rule.production, quantity_from_int(neighbors)));
+        demand = quantity_add(demand, quantity_mul(rule.demand, quantity_from_int(neighbors)));
+    }
+
+    const Quantity modifier_max = quantity_from_float(ADJACENCY_MODIFIER_MAX);
+    production = quantity_clamp(production, 0, modifier_max);
+    demand = quantity_clamp(demand, 0, modifier_max);
+    for (int i = t->stock; i < t->stock + (int)t->stock_count; ++i) {
+        StockInfo* info = &world->stock_info[i];
+        info->production_modifier = production;
+        info->demand_modifier = demand;
+        world->stocks[i].production_rate = quantity_mul(info->production, production);
+        world->stocks[i].demand_rate = quantity_mul(info->demand, demand);
+    }
+}
+
+// Recomputes the rates of the tiles that q/r can be a neighbor of
+static void world_update_area_rates(World* world, int q, int r)
+{
+    Hex area[hex_spiral_count(ADJACENCY_RADIUS)];
+    int count = hex_spiral(Hex{ q, r }, ADJACENCY_RADIUS, area, hex_spiral_count(ADJACENCY_RADIUS));
+    for (int i = 0; i < count; ++i) {
+        if (area[i].q < 0 || area[i].q >= world->max_q || area[i].r < 0 || area[i].r >= world->max_r) continue;
+        world_update_rates(world, area[i]);
+    }
+}
+
 // To think about:
 // various types of production
 // Continous: draw resources from storage and make the product
@@ -39,47 +264,156 @@ Tile* world_get_tile(World* w, int q, int r) {
 // supply side, only when the growing cycle is done does the good get added
 // Work Power ... if more people are on the tile production should be per person
 
+struct WorldMetrics {
+    bool registered;
+    MetricId ticks;
+    MetricId tiles_processed;
+    MetricId tiles_blocked;
+    MetricId people;
+    MetricId supply[GOOD_COUNT];
+};
+
+static WorldMetrics _metrics = { 0 };
+
+static void world_register_metrics()
+{
+    static const char* supply_names[GOOD_COUNT] = { "economia_supply_wood", "economia_supply_wheat" };
+
+    _metrics.ticks = telemetry_counter("economia_ticks", "Simulation ticks");
+    _metrics.tiles_processed = telemetry_counter("economia_tiles_processed", "Tiles that did work");
+    _metrics.tiles_blocked = telemetry_counter("economia_tiles_blocked", "Tiles that lacked supply to work");
+    _metrics.people = telemetry_gauge("economia_people", "People in the world");
+    for (int g = 0; g < GOOD_COUNT; ++g) {
+        _metrics.supply[g] = telemetry_gauge(supply_names[g], "Supply stored over all tiles");
+    }
+    _metrics.registered = true;
+}
+
 static void world_update_production(World* world, float dt) {
-    for (int i = 0; i < world->tile_count; ++i) {
-        bool doWork = true;
-        Tile* t = &world->tiles[i];
-        if (t->type == ECONOMY_TILE_NONE) continue;
+    // Counted locally and published once per tick, the metrics are shared between threads
+    int processed = 0;
+    int blocked = 0;
+    int64_t supply_total[GOOD_COUNT] = { 0 };
+    // The only float of the tick, everything below is integer math
+    Quantity step = quantity_from_float(dt);
 
-        for (int g = 0; g < GOOD_COUNT; ++g) {
-            if (t->supply[g] < t->demand[g] * dt) {
-                doWork = false;
-            }
+    // Only the stocks are touched, block by block so a tile works when all its demands are met
+    int count = 1;
+    for (int i = 0; i < world->stock_used; i += count) {
+        Stock* block = &world->stocks[i];
+        count = block->count;
+        if (block->good == GOOD_NONE) continue;
+
+        // In 64 bits nothing can overflow, clamping to the capacity saturates the result
+        int64_t produced[GOOD_COUNT];
+        int64_t used[GOOD_COUNT];
+        bool doWork = true;
+        for (int g = 0; g < count; ++g) {
+            produced[g] = ((int64_t)block[g].production_rate * step) >> QUANTITY_SHIFT;
+            used[g] = ((int64_t)block[g].demand_rate * step) >> QUANTITY_SHIFT;
+            doWork &= block[g].supply >= used[g];
         }
 
+        if (!doWork) ++blocked;
+
         if (doWork) {
+            ++processed;
             // In general a place is not going to use the same resource
             // as it produces
-            for (int g = 0; g < GOOD_COUNT; ++g) {
-                t->supply[g] += t->production[g] * dt - t->demand[g] * dt;
-                t->supply[g] = Clamp(t->supply[g], 0, t->supplyMax[g]);
+            for (int g = 0; g < count; ++g) {
+                Stock* s = &block[g];
+                int64_t supply = s->supply + produced[g] - used[g];
+                s->supply = (Quantity)((supply < 0) ? 0 : ((supply > s->supply_max) ? s->supply_max : supply));
+
+                // The level only needs a division once the supply leaves the range of the current one
+                int64_t scaled = (int64_t)s->supply * SUPPLY_LEVELS;
+                int64_t low = (int64_t)s->level * s->supply_max;
+                if (scaled < low || scaled >= low + s->supply_max) {
+                    int level = (s->supply_max > 0) ? (int)(scaled / s->supply_max) : 0;
+                    if (level != s->level) {
+                        s->level = (unsigned char)level;
+                        world_mark_changed(world, s->tile);
+                    }
+                }
             }
         }
+
+        for (int g = 0; g < count; ++g) supply_total[block[g].good] += block[g].supply;
     }
+
+    if (!_metrics.registered) world_register_metrics();
+    telemetry_add(_metrics.ticks, 1);
+    telemetry_add(_metrics.tiles_processed, processed);
+    telemetry_add(_metrics.tiles_blocked, blocked);
+    telemetry_set(_metrics.people, world->people_count);
+    for (int g = 0; g < GOOD_COUNT; ++g) telemetry_set(_metrics.supply[g], quantity_to_double(supply_total[g]));
 }
 
-const char* world_get_tile_info(World* e,int q, int r) {
-    static char buffer[1024] = { 0 };
-    Tile* t = world_get_tile(e, q, r);
-    if (t == nullptr) return "INVALID TILE";
-    else {
-        int end = 0;
-        TextAppend(buffer, TextFormat("Tile: %d/%d\n", q, r), &end);
-        for (int i = 0; i < GOOD_COUNT; ++i) {
-            TextAppend(buffer, TextFormat("%f,", t->supply[i]), &end);
-        }
+int world_get_tile_info(const World* world, int q, int r, char* buffer, int size) {
+    int end = 0;
+    if (q < 0 || q >= world->max_q || r < 0 || r >= world->max_r) {
+        format_append(buffer, size, &end, "INVALID TILE");
+        return end;
+    }
+
+    const Tile* t = &world->tiles[q * world->max_r + r];
+    format_append(buffer, size, &end, "Tile: %d/%d\n", q, r);
+    for (int i = 0; i < GOOD_COUNT; ++i) {
+        int stock = world_find_stock(world, t, i);
+        format_append(buffer, size, &end, "%f,", (stock >= 0) ? quantity_to_float(world->stocks[stock].supply) : 0.0f);
     }
-    return buffer;
+    if (t->stock_count > 0) {
+        const StockInfo* info = &world->stock_info[t->stock];
+        format_append(buffer, size, &end, "\nModifiers: x%.2f/x%.2f", quantity_to_float(info->production_modifier),
+            quantity_to_float(info->demand_modifier));
+    }
+    return end;
 }
 
 void world_update(World* world, float dt)
 {
     bool doWork = true;
     world_update_production(world, dt);
+    ++world->tick;
+}
+
+static bool tile_links(int type)
+{
+    return type == ECONOMY_TILE_ROAD || type == ECONOMY_TILE_RIVER;
+}
+
+unsigned int world_link_mask(World* world, int type, int q, int r)
+{
+    if (!tile_links(type)) return 0;
+
+    unsigned int mask = 0;
+    for (int i = 0; i < 6; ++i) {
+        int nq = q + hex_directions[i].q;
+        int nr = r + hex_directions[i].r;
+        if (nq < 0 || nq >= world->max_q || nr < 0 || nr >= world->max_r) continue;
+        if (world->tiles[nq * world->max_r + nr].type == type) mask |= 1u << i;
+    }
+    return mask;
+}
+
+// Picks the model and rotation of a road or river from the neighbors it connects to
+static void world_update_links(World* world, int q, int r)
+{
+    if (q < 0 || q >= world->max_q || r < 0 || r >= world->max_r) return;
+
+    Tile* t = &world->tiles[q * world->max_r + r];
+    if (!tile_links(t->type)) {
+        t->links = 0;
+        return;
+    }
+
+    unsigned int links = world_link_mask(world, t->type, q, r);
+    if (links != t->links) world_mark_changed(world, q * world->max_r + r);
+    t->links = links;
+    AutoTile shape = autotile_lookup(t->links);
+    int first = (t->type == ECONOMY_TILE_ROAD) ? MODEL_PATH_END : MODEL_RIVER_END;
+    t->model_type = first + shape.shape;
+    t->rotation = shape.rotation;
 }
 
 void world_add_tile(World* world, Tile tile, int q, int r)
@@ -93,22 +427,25 @@ void world_add_tile(World* world, Tile tile, int q, int r)
     Tile* t = world_get_tile(world, q, r);
     if (t == nullptr) return;
 
+    int previous = t->type;
+    // The goods start over, even if the type stays the same
+    world_free_stock(world, t);
     t->type = tile.type;
+    if (previous >= 0 && previous < ECONOMY_TILE_COUNT) bitboard_set(&world->layers[previous], q, r, false);
+    if (t->type >= 0 && t->type < ECONOMY_TILE_COUNT) bitboard_set(&world->layers[t->type], q, r, true);
     t->rotation = tile.rotation;
+    ++world->revision;
+    world_mark_changed(world, index);
 
     switch (t->type) {
     case (ECONOMY_TILE_FARM): {
         TraceLog(LOG_INFO, "Farm placed at %d/%d", q, r);
         t->model_type = MODEL_BUILDING_FARM;
-        t->production[GOOD_WHEAT] = 1.0;
-        t->supplyMax[GOOD_WHEAT] = 100.0;
         break;
     }
     case (ECONOMY_TILE_FOREST): {
         TraceLog(LOG_INFO, "Forest placed at %d/%d", q, r);
         t->model_type = MODEL_BUILDING_FOREST;
-        t->production[GOOD_WOOD] = 1.0;
-        t->supplyMax[GOOD_WOOD] = 100.0;
         break;
     }
     case (ECONOMY_TILE_HOUSE): {
@@ -122,7 +459,37 @@ void world_add_tile(World* world, Tile tile, int q, int r)
         t->model_type = MODEL_BUILDING_GRASS;
         break;
     }
+    case (ECONOMY_TILE_ROAD):
+    case (ECONOMY_TILE_RIVER): {
+        TraceLog(LOG_INFO, "%s placed at %d/%d", (t->type == ECONOMY_TILE_ROAD) ? "Road" : "River", q, r);
+        break;
+    }
     }
+
+    int goods = (t->type >= 0) ? recipe_goods(t->type) : 0;
+    int stock = (goods > 0) ? world_alloc_stock(world, index, goods) : -1;
+    if (stock >= 0) {
+        t->stock = stock;
+        t->stock_count = goods;
+        for (const TileRecipe& recipe : _recipes) {
+            if (recipe.type != t->type) continue;
+            world->stocks[stock].good = (signed char)recipe.good;
+            world->stocks[stock].supply_max = recipe.supply_max;
+            world->stock_info[stock].production = recipe.production;
+            world->stock_info[stock].demand = recipe.demand;
+            ++stock;
+        }
+    }
+
+    // Only this tile and its neighbors can change their shape
+    if (tile_links(previous) || tile_links(t->type)) {
+        world_update_links(world, q, r);
+        for (int i = 0; i < 6; ++i) {
+            world_update_links(world, q + hex_directions[i].q, r + hex_directions[i].r);
+        }
+    }
+
+    world_update_area_rates(world, q, r);
 }
 
 /// Returns the first person found that has the give address
@@ -144,10 +511,11 @@ void world_add_person(World* world, int type, int q, int r)
         TraceLog(LOG_WARNING, "Trying to add person on empty spot %d/%d", q, r);
         return;
     }
-    if (world->people_count <= PEOPLE_MAX) {
+    if (world->people_count < PEOPLE_MAX) {
         Person* p = &world->people[world->people_count];
         *p = Person{ .model_type = type, .q = q, .r = r, .tile_pos = Vector3{0,.25f,0} };
         ++world->people_count;
+        ++world->revision;
     }
     else {
         TraceLog(LOG_WARNING, "Exceeded maximum number of people (%d)", PEOPLE_MAX);
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "raymath.hpp"
+#include "arena.hpp"
+#include "bitboard.hpp"
+#include "quantity.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
 
 /*
 This is responsible for managing and trackign the world state
@@ -20,17 +26,44 @@ enum TileType {
     ECONOMY_TILE_FARM,
     ECONOMY_TILE_HOUSE,
     ECONOMY_TILE_FOREST,
+    ECONOMY_TILE_ROAD,      // Connects to neighboring roads, see autotile.hpp
+    ECONOMY_TILE_RIVER,     // Connects to neighboring rivers
     ECONOMY_TILE_COUNT
 };
 
+// What the draw loop and the layers need, packed so large boards stay in cache. The goods a tile works
+// with are kept apart in World::stocks, only tiles that have some take up space there
 struct Tile {
-    int type;
-    int model_type;
-    int rotation;
-    float production[GOOD_COUNT] = { 0 }; // amount produced per sec WHEN demand is fullfilled from storage 
-    float demand[GOOD_COUNT] = { 0 };  // amount used to do work per sec
-    float supply[GOOD_COUNT] = { 0 }; // Total amount available 
-    float supplyMax[GOOD_COUNT] = { 0 };
+    int type : 4;                   // TileType, signed for ECONOMY_TILE_NONE
+    int model_type : 8;             // BuildingType, see assets.hpp
+    unsigned int rotation : 3;      // In steps of 60 degrees
+    unsigned int links : 6;         // Neighbors a road or river connects to, bit i is hex_directions[i]
+    unsigned int stock_count : 4;   // Entries in World::stocks starting at stock, 0 for none
+    int stock;
+};
+
+static_assert(sizeof(Tile) == 8, "Tile is packed into 8 bytes, see the bitfields");
+
+// What the tick reads and writes, one per good of a tile. Goods are fixed point, see quantity.hpp
+struct Stock {
+    Quantity supply;                // Total amount available
+    Quantity supply_max;
+    // Amounts per sec scaled by the neighbors, only recomputed when a tile close by changes
+    Quantity production_rate;       // Produced WHEN the demand is fullfilled from storage
+    Quantity demand_rate;           // Used to do work
+    int tile;                       // Index of the tile, the next free block of this size while unused
+    signed char good;               // GOOD_NONE while unused
+    unsigned char level;            // supply/supply_max in SUPPLY_LEVELS steps
+    unsigned char count;            // Entries in the block this one belongs to, the same for all of them
+};
+
+// The rest of a stock, only needed when neighbors change or for display
+struct StockInfo {
+    Quantity production;
+    Quantity demand;
+    // Neighbors scale production and demand, see _adjacency_rules
+    Quantity production_modifier;
+    Quantity demand_modifier;
 };
 
 struct Person {
@@ -41,7 +74,26 @@ struct Person {
     Vector3 tile_pos;
 };
 
+// The benchmarks raise this to measure large populations
+#ifndef PEOPLE_MAX
 #define PEOPLE_MAX 100
+#endif
+
+// Upper bound of the adjacency modifiers, no matter how many neighbors help
+#define ADJACENCY_MODIFIER_MAX 2.0f
+
+// Sub-arenas of the world memory, one per subsystem
+enum WorldArena {
+    WORLD_ARENA_TILES,
+    WORLD_ARENA_CHANGES,
+    WORLD_ARENA_LAYERS,
+    WORLD_ARENA_STOCKS,
+    WORLD_ARENA_SCRATCH,    // Temporaries of region queries like bitboard_components, rewound after each
+    WORLD_ARENA_COUNT
+};
+
+// Supply changes are only reported once they move a tile by 1/SUPPLY_LEVELS of its maximum
+#define SUPPLY_LEVELS 16
 
 struct World {
     int max_q;
@@ -50,14 +102,51 @@ struct World {
     Tile *tiles;
     int people_count;
     Person people[PEOPLE_MAX] = { 0 };
+    int revision; // Incremented whenever tiles or people are added
+    // Tiles that were placed or changed their supply level since the last world_clear_changes,
+    // every tile is listed at most once
+    int* changes;
+    int change_count;
+    unsigned char* changed;
+    Bitboard layers[ECONOMY_TILE_COUNT];    // Hexes of each tile type, kept up to date by world_add_tile
+    // The goods of all tiles in blocks of Tile::stock_count entries, stock_info has the same layout.
+    // Blocks that are given up are reused by tiles with as many goods
+    Stock* stocks;
+    StockInfo* stock_info;
+    int stock_used;                         // Entries up to the end of the last block
+    int stock_capacity;
+    int stock_free[GOOD_COUNT + 1];         // First free block of each size, -1 for none
+    // Random numbers are keyed by seed and tick, see rng.hpp. The seed is 0 unless set before the first
+    // update, tick counts the updates
+    uint64_t seed;
+    uint32_t tick;
+    // The world itself and everything it points to live in memory, one block that world_destroy
+    // releases at once. Ticks don't allocate
+    Arena memory;
+    Arena arenas[WORLD_ARENA_COUNT];
 };
 
 World* world_create(int board_max_q, int board_max_r);
 void world_destroy(World* world);
+// Empties the board and the population, keeps the size, the seed and the memory
+void world_reset(World* world);
+// Bytes the world allocated, the stock pool in there is reserved for every tile having the most goods
+size_t world_footprint(const World* world);
+// Logs the use of every sub-arena
+void world_log_memory(const World* world);
 Tile* world_get_tile(World* w, int q, int r);
-const char* world_get_tile_info(World* e, int q, int r);
+// Entry of good in World::stocks and World::stock_info, -1 if the tile doesn't work with it
+int world_find_stock(const World* world, const Tile* tile, int good);
+// Writes a description of the tile into buffer, returns its length
+int world_get_tile_info(const World* world, int q, int r, char* buffer, int size);
 void world_update(World* world, float dt);
+
+// Forget the changes, call once everything that follows them has seen them
+void world_clear_changes(World* world);
 void world_add_tile(World* world, Tile tile, int q, int r);
+
+// Mask of the neighbors of q/r that a tile of type would connect to
+unsigned int world_link_mask(World* world, int type, int q, int r);
 Person* world_get_person(World* w, int q, int r);
 
 void world_add_person(World* world, int type, int q, int r);
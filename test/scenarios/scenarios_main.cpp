@@ -0,0 +1,325 @@
+/*
+Whole game scenarios, each builds a world and runs it headless for a fixed number of ticks. The tick
+times, the peak resident memory and a checksum of the final world are compared against the baseline
+in baseline/<scenario>.json, every scenario runs as its own CTest test so the peak memory is its own.
+
+    Scenarios <scenario> <baseline directory> [--update]
+
+--update writes the measured values as the new baseline together with the default tolerances, a
+baseline can loosen them for a noisy scenario. A different checksum means the simulation
+isn't deterministic anymore or its rules changed, in the latter case the baseline has to be updated
+with the change. Tick times are only compared in optimized builds (NDEBUG), a debug build checks the
+checksum and the memory. After the timed run the world is reset and the scenario replayed, the replay
+has to end with the same checksum.
+*/
+
+#include "unity.h"
+#include "raylib.h"
+#include "world.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#define SCENARIO_TICKS_MAX 1000
+#define SCENARIO_DT (1.0f / 60)
+// Default tolerances written with a new baseline, each baseline file can loosen them
+#define SCENARIO_P50_TOLERANCE 1.5      // Allowed slowdown over the baseline
+#define SCENARIO_P99_TOLERANCE 2.5
+#define SCENARIO_RSS_TOLERANCE 1.25
+#define SCENARIO_TIME_SLACK_MS 0.25     // Ticks this much slower always pass, short ticks are noisy
+
+size_t scenario_peak_rss();
+
+struct Scenario {
+    const char* name;
+    int board_size;
+    int ticks;
+    void (*setup)(World* world);
+    void (*tick)(World* world, int tick);   // Optional, runs before world_update
+};
+
+struct ScenarioResult {
+    unsigned long long checksum;
+    unsigned long long replay_checksum;     // After world_reset and running the scenario again
+    double p50_ms;
+    double p99_ms;
+    double peak_rss_mb;
+    double p50_tolerance;
+    double p99_tolerance;
+    double rss_tolerance;
+};
+
+static const Scenario* _scenario = nullptr;
+static const char* _baseline_dir = nullptr;
+static bool _update = false;
+
+// Farms and forests in bands with houses in between, the bulk of the board produces every tick
+static void scenario_farm_forest_setup(World* world)
+{
+    for (int q = 0; q < world->max_q; ++q) {
+        for (int r = 0; r < world->max_r; ++r) {
+            int type = ((q / 8) % 2 == 0) ? ECONOMY_TILE_FARM : ECONOMY_TILE_FOREST;
+            if ((q + r) % 13 == 0) type = ECONOMY_TILE_HOUSE;
+            world_add_tile(world, Tile{ .type = type }, q, r);
+        }
+    }
+}
+
+// A grass town with houses, crowded with people
+static void scenario_town_setup(World* world)
+{
+    for (int q = 0; q < world->max_q; ++q) {
+        for (int r = 0; r < world->max_r; ++r) {
+            int type = ((q * 3 + r) % 7 == 0) ? ECONOMY_TILE_HOUSE : ECONOMY_TILE_GRASS;
+            world_add_tile(world, Tile{ .type = type }, q, r);
+        }
+    }
+
+    unsigned int seed = 1;
+    for (int i = 0; i < 50000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        unsigned int value = seed >> 8;
+        world_add_person(world, 0, value % world->max_q, (value / world->max_q) % world->max_r);
+    }
+}
+
+static void scenario_town_tick(World* world, int tick)
+{
+    // The selection, a scan over all people
+    world_get_person(world, tick % world->max_q, (tick * 7) % world->max_r);
+}
+
+static void scenario_road_network_setup(World* world)
+{
+    for (int q = 0; q < world->max_q; ++q) {
+        for (int r = 0; r < world->max_r; ++r) {
+            world_add_tile(world, Tile{ .type = ((q + r) % 5 == 0) ? ECONOMY_TILE_FARM : ECONOMY_TILE_GRASS }, q, r);
+        }
+    }
+}
+
+// Keeps building roads and rivers, every placement relinks the neighbors
+static void scenario_road_network_tick(World* world, int tick)
+{
+    for (int i = 0; i < 64; ++i) {
+        int step = tick * 64 + i;
+        int q = (step * 7) % world->max_q;
+        int r = (step / world->max_q * 3 + step) % world->max_r;
+        world_add_tile(world, Tile{ .type = (step % 3 == 0) ? ECONOMY_TILE_RIVER : ECONOMY_TILE_ROAD }, q, r);
+    }
+}
+
+static const Scenario _scenarios[] = {
+    { "farm_forest", 1000, 200, scenario_farm_forest_setup, nullptr },
+    { "town", 256, 500, scenario_town_setup, scenario_town_tick },
+    { "road_network", 512, 500, scenario_road_network_setup, scenario_road_network_tick },
+};
+
+static unsigned long long scenario_hash(unsigned long long hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+// Everything the simulation decides, not the padding. Hashed as full ints and one supply per good so
+// the checksum doesn't depend on how tiles are packed
+static unsigned long long scenario_checksum(const World* world)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (int i = 0; i < world->tile_count; ++i) {
+        const Tile* t = &world->tiles[i];
+        int type = t->type;
+        int model_type = t->model_type;
+        unsigned int links = t->links;
+        Quantity supply[GOOD_COUNT] = { 0 };
+        for (int g = 0; g < GOOD_COUNT; ++g) {
+            int stock = world_find_stock(world, t, g);
+            if (stock >= 0) supply[g] = world->stocks[stock].supply;
+        }
+        hash = scenario_hash(hash, &type, sizeof(type));
+        hash = scenario_hash(hash, &model_type, sizeof(model_type));
+        hash = scenario_hash(hash, &links, sizeof(links));
+        hash = scenario_hash(hash, supply, sizeof(supply));
+    }
+    for (int i = 0; i < world->people_count; ++i) {
+        const Person* p = &world->people[i];
+        hash = scenario_hash(hash, &p->q, sizeof(p->q));
+        hash = scenario_hash(hash, &p->r, sizeof(p->r));
+    }
+    return hash;
+}
+
+static int scenario_compare(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+// Sets the scenario up on an empty world and runs count ticks, with the time of each in ticks if given
+static void scenario_play(const Scenario* scenario, World* world, int count, double* ticks)
+{
+    char info[256];
+
+    scenario->setup(world);
+    world_clear_changes(world);
+
+    for (int i = 0; i < count; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (scenario->tick != nullptr) scenario->tick(world, i);
+        world_update(world, SCENARIO_DT);
+        world_get_tile_info(world, i % world->max_q, i % world->max_r, info, sizeof(info));
+        world_clear_changes(world);
+        if (ticks != nullptr) {
+            ticks[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+}
+
+static ScenarioResult scenario_run(const Scenario* scenario)
+{
+    static double ticks[SCENARIO_TICKS_MAX];
+
+    World* world = world_create(scenario->board_size, scenario->board_size);
+    int count = (scenario->ticks < SCENARIO_TICKS_MAX) ? scenario->ticks : SCENARIO_TICKS_MAX;
+    scenario_play(scenario, world, count, ticks);
+    qsort(ticks, count, sizeof(double), scenario_compare);
+
+    ScenarioResult result = { 0 };
+    result.checksum = scenario_checksum(world);
+    result.p50_ms = ticks[count / 2];
+    result.p99_ms = ticks[(count * 99) / 100];
+    result.peak_rss_mb = scenario_peak_rss() / (1024.0 * 1024.0);
+
+    world_reset(world);
+    scenario_play(scenario, world, count, nullptr);
+    result.replay_checksum = scenario_checksum(world);
+    world_destroy(world);
+    return result;
+}
+
+static bool scenario_read_number(const char* text, const char* key, double* value)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char* found = strstr(text, pattern);
+    if (found == nullptr) return false;
+    found = strchr(found + strlen(pattern), ':');
+    if (found == nullptr) return false;
+    ++found;
+    while (*found == ' ' || *found == '"') ++found;
+    *value = strtod(found, nullptr);
+    return true;
+}
+
+static bool scenario_read_baseline(const char* filename, ScenarioResult* baseline)
+{
+    char text[1024] = { 0 };
+    FILE* file = fopen(filename, "rb");
+    if (file == nullptr) return false;
+    size_t size = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    text[size] = '\0';
+
+    // The checksum is a hex string, a double can't hold it
+    const char* checksum = strstr(text, "\"checksum\"");
+    if (checksum == nullptr || (checksum = strstr(checksum, "0x")) == nullptr) return false;
+    baseline->checksum = strtoull(checksum, nullptr, 16);
+
+    baseline->p50_tolerance = SCENARIO_P50_TOLERANCE;
+    baseline->p99_tolerance = SCENARIO_P99_TOLERANCE;
+    baseline->rss_tolerance = SCENARIO_RSS_TOLERANCE;
+    scenario_read_number(text, "p50_tolerance", &baseline->p50_tolerance);
+    scenario_read_number(text, "p99_tolerance", &baseline->p99_tolerance);
+    scenario_read_number(text, "rss_tolerance", &baseline->rss_tolerance);
+
+    return scenario_read_number(text, "p50_ms", &baseline->p50_ms) &&
+        scenario_read_number(text, "p99_ms", &baseline->p99_ms) &&
+        scenario_read_number(text, "peak_rss_mb", &baseline->peak_rss_mb);
+}
+
+static bool scenario_write_baseline(const char* filename, const Scenario* scenario, const ScenarioResult* result)
+{
+    FILE* file = fopen(filename, "wb");
+    if (file == nullptr) return false;
+    fprintf(file, "{\n  \"scenario\": \"%s\",\n  \"ticks\": %d,\n  \"checksum\": \"0x%016llx\",\n"
+        "  \"p50_ms\": %.3f,\n  \"p99_ms\": %.3f,\n  \"peak_rss_mb\": %.1f,\n"
+        "  \"p50_tolerance\": %.2f,\n  \"p99_tolerance\": %.2f,\n  \"rss_tolerance\": %.2f\n}\n",
+        scenario->name, scenario->ticks, result->checksum, result->p50_ms, result->p99_ms, result->peak_rss_mb,
+        SCENARIO_P50_TOLERANCE, SCENARIO_P99_TOLERANCE, SCENARIO_RSS_TOLERANCE);
+    fclose(file);
+    return true;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void test_scenario(void)
+{
+    char filename[512];
+    char message[768];
+    snprintf(filename, sizeof(filename), "%s/%s.json", _baseline_dir, _scenario->name);
+
+    ScenarioResult result = scenario_run(_scenario);
+    printf("%s: checksum 0x%016llx p50 %.3f ms p99 %.3f ms peak rss %.1f MB\n", _scenario->name,
+        result.checksum, result.p50_ms, result.p99_ms, result.peak_rss_mb);
+
+    snprintf(message, sizeof(message), "Checksum 0x%016llx after world_reset, 0x%016llx before",
+        result.replay_checksum, result.checksum);
+    TEST_ASSERT_MESSAGE(result.replay_checksum == result.checksum, message);
+
+    if (_update) {
+        TEST_ASSERT_MESSAGE(scenario_write_baseline(filename, _scenario, &result), "Can't write the baseline");
+        return;
+    }
+
+    ScenarioResult baseline = { 0 };
+    snprintf(message, sizeof(message), "Can't read %s, run with --update to create it", filename);
+    TEST_ASSERT_MESSAGE(scenario_read_baseline(filename, &baseline), message);
+
+    snprintf(message, sizeof(message), "Checksum 0x%016llx, baseline 0x%016llx", result.checksum, baseline.checksum);
+    TEST_ASSERT_MESSAGE(result.checksum == baseline.checksum, message);
+
+    snprintf(message, sizeof(message), "Peak rss %.1f MB, baseline %.1f MB", result.peak_rss_mb, baseline.peak_rss_mb);
+    TEST_ASSERT_MESSAGE(result.peak_rss_mb <= baseline.peak_rss_mb * baseline.rss_tolerance, message);
+
+#if defined(NDEBUG)
+    snprintf(message, sizeof(message), "p50 %.3f ms, baseline %.3f ms", result.p50_ms, baseline.p50_ms);
+    TEST_ASSERT_MESSAGE(result.p50_ms <= baseline.p50_ms * baseline.p50_tolerance + SCENARIO_TIME_SLACK_MS, message);
+    snprintf(message, sizeof(message), "p99 %.3f ms, baseline %.3f ms", result.p99_ms, baseline.p99_ms);
+    TEST_ASSERT_MESSAGE(result.p99_ms <= baseline.p99_ms * baseline.p99_tolerance + SCENARIO_TIME_SLACK_MS, message);
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <scenario> <baseline directory> [--update]\n", argv[0]);
+        return 1;
+    }
+
+    for (const Scenario& scenario : _scenarios) {
+        if (strcmp(scenario.name, argv[1]) == 0) _scenario = &scenario;
+    }
+    if (_scenario == nullptr) {
+        fprintf(stderr, "Unknown scenario %s\n", argv[1]);
+        return 1;
+    }
+    _baseline_dir = argv[2];
+    _update = (argc > 3 && strcmp(argv[3], "--update") == 0);
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_scenario);
+    return UNITY_END();
+}
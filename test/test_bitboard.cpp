@@ -0,0 +1,145 @@
+#include "unity.h"
+
+#include "arena.hpp"
+#include "bitboard.hpp"
+#include "hex.hpp"
+
+#include <stdio.h>
+
+// Three words per row with a partial last one, so the carries between words and the tail mask are used
+static constexpr int _max_q = 9;
+static constexpr int _max_r = 130;
+
+static Bitboard _src = { 0 };
+static Bitboard _dst = { 0 };
+static Bitboard _scratch = { 0 };
+
+static void bitboard_test_init(void)
+{
+    TEST_ASSERT_TRUE(bitboard_init(&_src, _max_q, _max_r));
+    TEST_ASSERT_TRUE(bitboard_init(&_dst, _max_q, _max_r));
+    TEST_ASSERT_TRUE(bitboard_init(&_scratch, _max_q, _max_r));
+}
+
+static void bitboard_test_free(void)
+{
+    bitboard_free(&_src);
+    bitboard_free(&_dst);
+    bitboard_free(&_scratch);
+}
+
+// Every hex on the board is set exactly when it's within radius of center
+static void assert_within(const Bitboard* board, Hex center, int radius)
+{
+    for (int q = 0; q < _max_q; ++q) {
+        for (int r = 0; r < _max_r; ++r) {
+            bool expected = hex_distance(Hex{ q, r }, center) <= radius;
+            if (bitboard_get(board, q, r) != expected) {
+                char message[64];
+                snprintf(message, sizeof(message), "Hex %d/%d around %d/%d", q, r, center.q, center.r);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+}
+
+// The center and its six neighbors, in the middle of a word, on both sides of a word boundary and at
+// the corners of the board where some neighbors fall off
+void test_bitboard_dilate_single_hex(void)
+{
+    bitboard_test_init();
+
+    const Hex centers[] = { { 4, 10 }, { 4, 63 }, { 4, 64 }, { 0, 0 }, { _max_q - 1, _max_r - 1 }, { 0, _max_r - 1 } };
+    for (Hex center : centers) {
+        bitboard_clear(&_src);
+        bitboard_set(&_src, center.q, center.r, true);
+        bitboard_dilate(&_dst, &_src);
+
+        int on_board = 1;
+        for (Hex direction : hex_directions) {
+            Hex neighbor = center + direction;
+            if (neighbor.q >= 0 && neighbor.q < _max_q && neighbor.r >= 0 && neighbor.r < _max_r) ++on_board;
+        }
+        TEST_ASSERT_EQUAL_INT(on_board, bitboard_count(&_dst));
+        assert_within(&_dst, center, 1);
+    }
+
+    bitboard_test_free();
+}
+
+void test_bitboard_dilate_n_matches_distance(void)
+{
+    bitboard_test_init();
+
+    const Hex centers[] = { { 4, 64 }, { 1, 127 }, { 7, 2 } };
+    for (Hex center : centers) {
+        bitboard_clear(&_src);
+        bitboard_set(&_src, center.q, center.r, true);
+        bitboard_dilate_n(&_dst, &_src, 3, &_scratch);
+        assert_within(&_dst, center, 3);
+    }
+
+    bitboard_test_free();
+}
+
+// A line along q = 2 across both word boundaries that turns into the next rows at its end, next to it
+// a blob that only touches it through a hex that isn't in the mask
+static void bitboard_test_mask(Bitboard* mask)
+{
+    bitboard_clear(mask);
+    for (int r = 10; r <= 100; ++r) bitboard_set(mask, 2, r, true);
+    bitboard_set(mask, 3, 100, true);
+    bitboard_set(mask, 4, 99, true);
+    for (int r = 102; r < _max_r; ++r) bitboard_set(mask, 2, r, true);
+    bitboard_set(mask, 6, 70, true);
+    bitboard_set(mask, 6, 71, true);
+    bitboard_set(mask, 7, 70, true);
+}
+
+static bool bitboard_test_in_line(int q, int r)
+{
+    return (q == 2 && r >= 10 && r <= 100) || (q == 3 && r == 100) || (q == 4 && r == 99);
+}
+
+void test_bitboard_flood_fill_stops_at_mask(void)
+{
+    bitboard_test_init();
+    bitboard_test_mask(&_src);
+
+    bitboard_flood_fill(&_dst, &_src, 2, 10, &_scratch);
+    for (int q = 0; q < _max_q; ++q) {
+        for (int r = 0; r < _max_r; ++r) TEST_ASSERT_EQUAL_INT(bitboard_test_in_line(q, r), bitboard_get(&_dst, q, r));
+    }
+
+    // Outside of the mask the fill is empty
+    bitboard_flood_fill(&_dst, &_src, 2, 101, &_scratch);
+    TEST_ASSERT_FALSE(bitboard_any(&_dst));
+
+    bitboard_test_free();
+}
+
+void test_bitboard_components_labels(void)
+{
+    static int labels[_max_q * _max_r];
+    Arena arena = { 0 };
+    TEST_ASSERT_TRUE(arena_init(&arena, "test", BITBOARD_COMPONENTS_BOARDS * arena_size(bitboard_size(_max_q, _max_r)),
+        MEMORY_TAG_WORLD));
+    bitboard_test_init();
+    bitboard_test_mask(&_src);
+
+    // Found in word order, the line first, then the rest of row 2 after the gap, then the blob
+    TEST_ASSERT_EQUAL_INT(3, bitboard_components(&_src, labels, &arena));
+    TEST_ASSERT_EQUAL_INT(0, arena.used);
+    for (int q = 0; q < _max_q; ++q) {
+        for (int r = 0; r < _max_r; ++r) {
+            int expected = -1;
+            if (bitboard_test_in_line(q, r)) expected = 0;
+            else if (q == 2 && r >= 102) expected = 1;
+            else if (bitboard_get(&_src, q, r)) expected = 2;
+            TEST_ASSERT_EQUAL_INT(expected, labels[q * _max_r + r]);
+        }
+    }
+
+    bitboard_test_free();
+    arena_free(&arena);
+}
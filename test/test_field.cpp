@@ -0,0 +1,110 @@
+#include "unity.h"
+
+#include "field.hpp"
+#include "hex.hpp"
+
+// Some value for every hex that isn't symmetric in q and r
+static float field_test_value(int q, int r)
+{
+    return (float)((q * 7 + r * 13) % 17) / 16.0f;
+}
+
+static void field_test_fill(Field* field)
+{
+    for (int q = 0; q < field->max_q; ++q) {
+        for (int r = 0; r < field->max_r; ++r) field_set(field, q, r, field_test_value(q, r));
+    }
+}
+
+// Outside of the board the nearest hex on it counts, like the ghosts
+static float field_test_clamped(const Field* field, int q, int r)
+{
+    q = (q < 0) ? 0 : ((q >= field->max_q) ? field->max_q - 1 : q);
+    r = (r < 0) ? 0 : ((r >= field->max_r) ? field->max_r - 1 : r);
+    return field_sample(field, q, r);
+}
+
+// 13 isn't a multiple of four, so every row has three hexes for SSE2 and one for the scalar tail. The
+// reference adds in the same order so the results have to be the same bits
+void test_field_step_matches_reference(void)
+{
+    static constexpr int max_q = 5;
+    static constexpr int max_r = 13;
+    const float diffusion = 0.1f;
+    const float decay = 0.05f;
+
+    Field field = { 0 };
+    TEST_ASSERT_TRUE(field_init(&field, max_q, max_r));
+    field_test_fill(&field);
+
+    float expected[max_q][max_r];
+    float keep = (1.0f - decay) * (1.0f - 6 * diffusion);
+    float spread = (1.0f - decay) * diffusion;
+    for (int q = 0; q < max_q; ++q) {
+        for (int r = 0; r < max_r; ++r) {
+            float sum = (field_test_clamped(&field, q, r - 1) + field_test_clamped(&field, q, r + 1)) +
+                (field_test_clamped(&field, q - 1, r) + field_test_clamped(&field, q - 1, r + 1)) +
+                (field_test_clamped(&field, q + 1, r) + field_test_clamped(&field, q + 1, r - 1));
+            expected[q][r] = keep * field_sample(&field, q, r) + spread * sum;
+        }
+    }
+
+    field_step(&field, diffusion, decay);
+    for (int q = 0; q < max_q; ++q) {
+        for (int r = 0; r < max_r; ++r) TEST_ASSERT_TRUE(field_sample(&field, q, r) == expected[q][r]);
+    }
+
+    field_free(&field);
+}
+
+void test_field_step_spreads_to_neighbors(void)
+{
+    const float diffusion = 0.1f;
+    Hex source = { 4, 6 };
+
+    Field field = { 0 };
+    TEST_ASSERT_TRUE(field_init(&field, 9, 13));
+    field_set(&field, source.q, source.r, 1.0f);
+    field_step(&field, diffusion, 0.0f);
+
+    for (int q = 0; q < field.max_q; ++q) {
+        for (int r = 0; r < field.max_r; ++r) {
+            Hex hex = { q, r };
+            float expected = 0.0f;
+            if (hex == source) expected = 1.0f - 6 * diffusion;
+            else if (hex_distance(hex, source) == 1) expected = diffusion;
+            TEST_ASSERT_TRUE(field_sample(&field, q, r) == expected);
+        }
+    }
+
+    field_free(&field);
+}
+
+// A field big enough for the worker threads against the same field stepped on this thread only
+void test_field_threaded_matches_serial(void)
+{
+    static constexpr int max_q = 512;
+    static constexpr int max_r = FIELD_PARALLEL_CELLS / max_q;
+
+    Field threaded = { 0 };
+    Field serial = { 0 };
+    TEST_ASSERT_TRUE(field_init(&threaded, max_q, max_r));
+    TEST_ASSERT_TRUE(field_init(&serial, max_q, max_r));
+    field_test_fill(&threaded);
+    field_test_fill(&serial);
+
+    bool workers = serial.threaded;
+    serial.threaded = false;
+    for (int i = 0; i < 4; ++i) {
+        field_step(&threaded, 0.1f, 0.01f);
+        field_step(&serial, 0.1f, 0.01f);
+    }
+    serial.threaded = workers;
+
+    for (int q = 0; q < max_q; ++q) {
+        for (int r = 0; r < max_r; ++r) TEST_ASSERT_TRUE(field_sample(&threaded, q, r) == field_sample(&serial, q, r));
+    }
+
+    field_free(&threaded);
+    field_free(&serial);
+}
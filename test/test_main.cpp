@@ -9,10 +9,37 @@ void tearDown(void) {
     // clean stuff up here
 }
 
+void test_picking_flat_tiles_next_to_building(void);
+void test_picking_building_replaced_by_flat_tile(void);
+void test_rng_known_answers(void);
+void test_rng_keyed_by_seed_tick_index(void);
+void test_rng_batch_matches_scalar(void);
+void test_rng_ranges(void);
+void test_bitboard_dilate_single_hex(void);
+void test_bitboard_dilate_n_matches_distance(void);
+void test_bitboard_flood_fill_stops_at_mask(void);
+void test_bitboard_components_labels(void);
+void test_field_step_matches_reference(void);
+void test_field_step_spreads_to_neighbors(void);
+void test_field_threaded_matches_serial(void);
+
 
 // not needed when using generate_test_runner.rb
 int main(void) {
     UNITY_BEGIN();
+    RUN_TEST(test_picking_flat_tiles_next_to_building);
+    RUN_TEST(test_picking_building_replaced_by_flat_tile);
+    RUN_TEST(test_rng_known_answers);
+    RUN_TEST(test_rng_keyed_by_seed_tick_index);
+    RUN_TEST(test_rng_batch_matches_scalar);
+    RUN_TEST(test_rng_ranges);
+    RUN_TEST(test_bitboard_dilate_single_hex);
+    RUN_TEST(test_bitboard_dilate_n_matches_distance);
+    RUN_TEST(test_bitboard_flood_fill_stops_at_mask);
+    RUN_TEST(test_bitboard_components_labels);
+    RUN_TEST(test_field_step_matches_reference);
+    RUN_TEST(test_field_step_spreads_to_neighbors);
+    RUN_TEST(test_field_threaded_matches_serial);
 
     return UNITY_END();
 }
\ No newline at end of file
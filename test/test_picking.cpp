@@ -0,0 +1,94 @@
+#include "unity.h"
+#include "raymath.hpp"
+
+#include "hex.hpp"
+#include "picking.hpp"
+#include "world.hpp"
+
+// The board of the gameplay screen
+static constexpr int _board_size = 7;
+static constexpr float _size = 1.0f / HEX_SQRT3;
+static constexpr float _ground = 0.2f;
+static constexpr float _building = 1.0f;
+
+// True if the ray passes through the column of hex below height, sampled finely
+static bool ray_hits_column(Ray ray, Vector3 origin, Hex hex, float height)
+{
+    const int steps = 256;
+    for (int i = 0; i <= steps; ++i) {
+        float y = height + (_ground - height) * i / steps;
+        float t = (origin.y + y - ray.position.y) / ray.direction.y;
+        Vector3 point = {
+            ray.position.x + ray.direction.x * t - origin.x,
+            0.0f,
+            ray.position.z + ray.direction.z * t - origin.z };
+        if (hex_from_world(point, _size) == hex) return true;
+    }
+    return false;
+}
+
+// Ray from the camera to the top of the flat tile hex
+static Ray ray_to_tile(Vector3 camera, Vector3 origin, Hex hex)
+{
+    Vector3 target = hex_to_world(hex, _size) + origin;
+    target.y = origin.y + _ground;
+    return Ray{ camera, Vector3Normalize(Vector3Subtract(target, camera)) };
+}
+
+static void picking_init_board(Vector3 origin)
+{
+    static World world = { 0 };
+    world.max_q = _board_size;
+    world.max_r = _board_size;
+    picking_init(&world, origin, _size, _ground);
+}
+
+// One building must not change which flat tile is picked, only the ones it stands in front of
+void test_picking_flat_tiles_next_to_building(void)
+{
+    Vector3 origin = hex_to_world(Hex{ -3, -3 }, _size);
+    picking_init_board(origin);
+
+    Hex farm = { 3, 3 };
+    picking_set_height(farm, _building);
+
+    Vector3 camera = { 0, 10, 10 };
+    for (int q = 0; q < _board_size; ++q) {
+        for (int r = 0; r < _board_size; ++r) {
+            Hex hex = { q, r };
+            if (hex == farm) continue;
+
+            Ray ray = ray_to_tile(camera, origin, hex);
+            Hex picked = { -1, -1 };
+            TEST_ASSERT_TRUE(picking_pick(ray, &picked));
+            if (picked == farm && ray_hits_column(ray, origin, farm, _building)) continue;
+            TEST_ASSERT_EQUAL_INT(q, picked.q);
+            TEST_ASSERT_EQUAL_INT(r, picked.r);
+        }
+    }
+
+    picking_unload();
+}
+
+// A flat tile placed over a building lowers the hex again, every tile is picked as if it was never there
+void test_picking_building_replaced_by_flat_tile(void)
+{
+    Vector3 origin = hex_to_world(Hex{ -3, -3 }, _size);
+    picking_init_board(origin);
+
+    Hex farm = { 3, 3 };
+    picking_set_height(farm, _building);
+    picking_set_height(farm, _ground);
+
+    Vector3 camera = { 0, 10, 10 };
+    for (int q = 0; q < _board_size; ++q) {
+        for (int r = 0; r < _board_size; ++r) {
+            Hex picked = { -1, -1 };
+            TEST_ASSERT_TRUE(picking_pick(ray_to_tile(camera, origin, Hex{ q, r }), &picked));
+            TEST_ASSERT_EQUAL_INT(q, picked.q);
+            TEST_ASSERT_EQUAL_INT(r, picked.r);
+        }
+    }
+
+    picking_unload();
+}
@@ -0,0 +1,74 @@
+#include "unity.h"
+
+#include "rng.hpp"
+
+struct RngKnownAnswer {
+    RngBlock counter;
+    uint64_t key;
+    RngBlock expected;
+};
+
+// From the Random123 distribution, kat_vectors
+static const RngKnownAnswer _known_answers[] = {
+    { { { 0, 0, 0, 0 } }, 0, { { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } } },
+    { { { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu } }, 0xffffffffffffffffull,
+        { { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu } } },
+    { { { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u } }, 0x299f31d0a4093822ull,
+        { { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u } } },
+};
+
+struct RngKeyedAnswer {
+    uint64_t seed;
+    uint32_t stream;
+    uint32_t tick;
+    uint32_t index;
+    RngBlock expected;
+};
+
+// Philox4x32-10 with the counter index, tick, stream, 0 and the seed as key, from a separate
+// implementation that reproduces the known answers above
+static const RngKeyedAnswer _keyed_answers[] = {
+    { 1, RNG_STREAM_HARVEST, 0, 0, { { 0xe3e80670u, 0xe50a0ebcu, 0x95f222c0u, 0xb615aa27u } } },
+    { 0x0123456789abcdefull, RNG_STREAM_HARVEST, 42, 7, { { 0xf4c18437u, 0x8fd4a3a9u, 0x93dd670du, 0xc8830ef6u } } },
+    { 0xdeadbeefcafef00dull, RNG_STREAM_EVENT, 1000, 123456, { { 0x38ce69bdu, 0x6c02481eu, 0x707f1971u, 0x08e952feu } } },
+    { 12345, RNG_STREAM_PERSON, 0xffffffffu, 0xffffffffu, { { 0x04ca4ab1u, 0x48fe3c9du, 0x6cc89dc7u, 0x2186b218u } } },
+};
+
+void test_rng_known_answers(void)
+{
+    for (const RngKnownAnswer& answer : _known_answers) {
+        RngBlock block = rng_philox(answer.counter, answer.key);
+        for (int i = 0; i < 4; ++i) TEST_ASSERT_EQUAL_HEX32(answer.expected.v[i], block.v[i]);
+    }
+}
+
+void test_rng_keyed_by_seed_tick_index(void)
+{
+    for (const RngKeyedAnswer& answer : _keyed_answers) {
+        RngBlock block = rng_block(answer.seed, answer.stream, answer.tick, answer.index);
+        for (int i = 0; i < 4; ++i) TEST_ASSERT_EQUAL_HEX32(answer.expected.v[i], block.v[i]);
+        TEST_ASSERT_EQUAL_HEX32(answer.expected.v[0], rng_u32(answer.seed, answer.stream, answer.tick, answer.index));
+    }
+}
+
+// The SIMD path has to give the same numbers, the count isn't a multiple of four to cover the tail
+void test_rng_batch_matches_scalar(void)
+{
+    uint32_t batch[37];
+    rng_u32_batch(0xdeadbeefcafef00dull, RNG_STREAM_EVENT, 1000, 123440, batch, 37);
+    for (int i = 0; i < 37; ++i) {
+        TEST_ASSERT_EQUAL_HEX32(rng_u32(0xdeadbeefcafef00dull, RNG_STREAM_EVENT, 1000, 123440 + i), batch[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX32(0x38ce69bdu, batch[123456 - 123440]);
+}
+
+void test_rng_ranges(void)
+{
+    for (uint32_t i = 0; i < 1000; ++i) {
+        TEST_ASSERT_TRUE(rng_below(7, RNG_STREAM_HARVEST, 3, i, 10) < 10);
+        float unit = rng_unit(7, RNG_STREAM_HARVEST, 3, i);
+        TEST_ASSERT_TRUE(unit >= 0.0f && unit < 1.0f);
+        int32_t fraction = rng_fraction(7, RNG_STREAM_HARVEST, 3, i);
+        TEST_ASSERT_TRUE(fraction >= 0 && fraction < 65536);
+    }
+}